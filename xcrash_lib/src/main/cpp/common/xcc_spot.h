@@ -44,6 +44,8 @@ typedef struct
     siginfo_t    siginfo;
     ucontext_t   ucontext;
     uint64_t     crash_time;
+    int          log_fd; //opened by the crashed process, shared with the dumper (same file offset)
+    int          snapshot; //dump the live process (no crash), resume the threads as soon as possible
 
     //set when inited
     int          api_level;
@@ -59,6 +61,8 @@ typedef struct
     int          dump_network_info;
     int          dump_all_threads;
     unsigned int dump_all_threads_count_max;
+    int          dump_binary; //write a binary tombstone alongside the text one
+    int          defer_symbols; //record the raw frames only, symbolize them on the next launch
 
     //set when crashed (content lenghts after this struct)
     size_t       log_pathname_len;
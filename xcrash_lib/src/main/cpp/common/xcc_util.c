@@ -32,6 +32,7 @@
 #include <fcntl.h>
 #include <time.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <sys/ptrace.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -247,7 +248,16 @@ char *xcc_util_trim(char *start)
     return start;
 }
 
-int xcc_util_write(int fd, const char *buf, size_t len)
+//buffered writer for the log FD (the dumper is single-threaded)
+//len is updated after the data is copied in, and off is updated after each write(),
+//so the signal handler can flush a consistent buffer whenever it interrupts the writer
+static int             xcc_util_writer_fd  = -1;
+static char           *xcc_util_writer_buf = NULL;
+static size_t          xcc_util_writer_cap = 0;
+static volatile size_t xcc_util_writer_len = 0;
+static volatile size_t xcc_util_writer_off = 0;
+
+static int xcc_util_write_direct(int fd, const char *buf, size_t len)
 {
     size_t      nleft;
     ssize_t     nwritten;
@@ -276,6 +286,81 @@ int xcc_util_write(int fd, const char *buf, size_t len)
     return 0;
 }
 
+int xcc_util_writer_init(int fd, size_t cap)
+{
+    void *buf;
+
+    if(fd < 0 || 0 == cap) return XCC_ERRNO_INVAL;
+    if(NULL != xcc_util_writer_buf) return XCC_ERRNO_STATE;
+
+    //no malloc(), the buffer is allocated once and never grows
+    if(MAP_FAILED == (buf = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))) return XCC_ERRNO_NOMEM;
+
+    xcc_util_writer_cap = cap;
+    xcc_util_writer_len = 0;
+    xcc_util_writer_off = 0;
+    xcc_util_writer_buf = (char *)buf;
+    xcc_util_writer_fd  = fd;
+    return 0;
+}
+
+int xcc_util_writer_flush(void)
+{
+    ssize_t nwritten;
+
+    if(NULL == xcc_util_writer_buf) return 0;
+
+    while(xcc_util_writer_off < xcc_util_writer_len)
+    {
+        errno = 0;
+        if((nwritten = write(xcc_util_writer_fd, xcc_util_writer_buf + xcc_util_writer_off, xcc_util_writer_len - xcc_util_writer_off)) <= 0)
+        {
+            if(nwritten < 0 && errno == EINTR)
+                continue; /* call write() again */
+            else
+                return XCC_ERRNO_SYS; /* error */
+        }
+        xcc_util_writer_off += (size_t)nwritten;
+    }
+
+    xcc_util_writer_len = 0;
+    xcc_util_writer_off = 0;
+    return 0;
+}
+
+//async-signal-safe, all the following writes go to the FD directly
+int xcc_util_writer_uninit(void)
+{
+    int   r;
+    char *buf;
+
+    if(NULL == (buf = xcc_util_writer_buf)) return 0;
+
+    r = xcc_util_writer_flush();
+    xcc_util_writer_fd  = -1;
+    xcc_util_writer_buf = NULL;
+    munmap(buf, xcc_util_writer_cap);
+    return r;
+}
+
+int xcc_util_write(int fd, const char *buf, size_t len)
+{
+    int r;
+
+    if(fd < 0) return XCC_ERRNO_INVAL;
+    if(fd != xcc_util_writer_fd || NULL == xcc_util_writer_buf) return xcc_util_write_direct(fd, buf, len);
+
+    if(len > xcc_util_writer_cap - xcc_util_writer_len)
+        if(0 != (r = xcc_util_writer_flush())) return r;
+
+    //too large to be buffered
+    if(len > xcc_util_writer_cap) return xcc_util_write_direct(fd, buf, len);
+
+    memcpy(xcc_util_writer_buf + xcc_util_writer_len, buf, len);
+    xcc_util_writer_len += len;
+    return 0;
+}
+
 int xcc_util_write_str(int fd, const char *str)
 {
     const char *tmp = str;
@@ -295,9 +380,25 @@ int xcc_util_write_format(int fd, const char *format, ...)
     va_list ap;
     char    buf[1024];
     ssize_t len;
+    int     r;
 
     if(fd < 0) return XCC_ERRNO_INVAL;
-    
+
+    //format into the writer's buffer directly
+    if(fd == xcc_util_writer_fd && NULL != xcc_util_writer_buf && xcc_util_writer_cap >= sizeof(buf))
+    {
+        if(xcc_util_writer_cap - xcc_util_writer_len < sizeof(buf))
+            if(0 != (r = xcc_util_writer_flush())) return r;
+
+        va_start(ap, format);
+        len = vsnprintf(xcc_util_writer_buf + xcc_util_writer_len, sizeof(buf), format, ap);
+        va_end(ap);
+
+        if(len <= 0) return 0;
+        xcc_util_writer_len += XCC_UTIL_MIN((size_t)len, sizeof(buf) - 1);
+        return 0;
+    }
+
     va_start(ap, format);
     len = vsnprintf(buf, sizeof(buf), format, ap);    
     va_end(ap);
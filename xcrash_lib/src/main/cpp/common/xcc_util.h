@@ -40,9 +40,11 @@ extern "C" {
 #define XCC_UTIL_THREAD_END "+++ +++ +++ +++ +++ +++ +++ +++ +++ +++ +++ +++ +++ +++ +++ +++\n"
 
 #define XCC_UTIL_XCRASH_DUMPER_FILENAME "libxcrash_dumper.so"
+#define XCC_UTIL_XCRASH_DUMPER_STANDBY  "--standby"
 
 #define XCC_UTIL_CRASH_TYPE_NATIVE "native"
 #define XCC_UTIL_CRASH_TYPE_ANR    "anr"
+#define XCC_UTIL_CRASH_TYPE_NATIVE_SNAPSHOT "native-snapshot"
 
 #if defined(__arm__)
 #define XCC_UTIL_ABI_STRING "arm"
@@ -139,6 +141,10 @@ int xcc_util_signal_has_sender(const siginfo_t* si, pid_t caller_pid);
 char *xcc_util_trim(char *start);
 int xcc_util_atoi(const char *str, int *i);
 
+int xcc_util_writer_init(int fd, size_t cap);
+int xcc_util_writer_flush(void);
+int xcc_util_writer_uninit(void);
+
 int xcc_util_write(int fd, const char *buf, size_t len);
 int xcc_util_write_str(int fd, const char *str);
 int xcc_util_write_format(int fd, const char *format, ...);
@@ -31,7 +31,9 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <jni.h>
 #include "xcc_errno.h"
 #include "xcc_fmt.h"
@@ -81,6 +83,27 @@ sig_atomic_t  xc_common_java_crashed      = 0;
 static int    xc_common_crash_prepared_fd = -1;
 static int    xc_common_trace_prepared_fd = -1;
 
+//opened placeholder files (filled by the java layer, taken by the signal handler)
+#define XC_COMMON_PLACEHOLDER_POOL_SIZE  2
+#define XC_COMMON_PLACEHOLDER_EMPTY      0
+#define XC_COMMON_PLACEHOLDER_FILLING    1
+#define XC_COMMON_PLACEHOLDER_READY      2
+#define XC_COMMON_PLACEHOLDER_TAKEN      3
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    int  state;
+    int  fd;
+    char pathname[1024];
+} xc_common_placeholder_t;
+#pragma clang diagnostic pop
+static xc_common_placeholder_t xc_common_placeholders[XC_COMMON_PLACEHOLDER_POOL_SIZE];
+static pthread_mutex_t         xc_common_placeholders_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+//fallocate() is only available since API level 21
+extern __attribute((weak)) int fallocate(int, int, off_t, off_t);
+
 static void xc_common_open_prepared_fd(int is_crash)
 {
     int fd = (is_crash ? xc_common_crash_prepared_fd : xc_common_trace_prepared_fd);
@@ -225,8 +248,136 @@ int xc_common_init(int         api_level,
     return r;
 }
 
-static int xc_common_open_log(int is_crash, uint64_t timestamp,
-                              char *pathname, size_t pathname_len, int *from_placeholder)
+// placeholder_01234567890123456789.clean.xcrash
+// file name length: 45
+static int xc_common_is_placeholder(const char *name)
+{
+    return (45 == strlen(name) &&
+            0 == memcmp(name, XC_COMMON_PLACEHOLDER_PREFIX"_", 12) &&
+            0 == memcmp(name + 32, XC_COMMON_PLACEHOLDER_SUFFIX, 13));
+}
+
+static int xc_common_is_placeholder_pooled(const char *pathname)
+{
+    size_t i;
+
+    for(i = 0; i < XC_COMMON_PLACEHOLDER_POOL_SIZE; i++)
+        if(XC_COMMON_PLACEHOLDER_READY == __atomic_load_n(&(xc_common_placeholders[i].state), __ATOMIC_ACQUIRE) &&
+           0 == strcmp(xc_common_placeholders[i].pathname, pathname)) return 1;
+    return 0;
+}
+
+//open some clean placeholder files in advance (not in the signal handler)
+void xc_common_fill_placeholder_pool(void)
+{
+    int                dir_fd, fd, empty;
+    char               buf[512];
+    char               placeholder_pathname[1024];
+    long               n, i;
+    size_t             j;
+    xcc_util_dirent_t *ent;
+    xc_common_placeholder_t *slot;
+
+    if(NULL == xc_common_log_dir) return;
+
+    pthread_mutex_lock(&xc_common_placeholders_mutex);
+
+    if((dir_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xc_common_log_dir, XC_COMMON_OPEN_DIR_FLAGS))) < 0) goto end;
+    while((n = syscall(XCC_UTIL_SYSCALL_GETDENTS, dir_fd, buf, sizeof(buf))) > 0)
+    {
+        for(i = 0; i < n; i += ent->d_reclen)
+        {
+            ent = (xcc_util_dirent_t *)(buf + i);
+            if(!xc_common_is_placeholder(ent->d_name)) continue;
+
+            xcc_fmt_snprintf(placeholder_pathname, sizeof(placeholder_pathname), "%s/%s", xc_common_log_dir, ent->d_name);
+            if(xc_common_is_placeholder_pooled(placeholder_pathname)) continue;
+
+            //find an empty slot
+            slot = NULL;
+            for(j = 0; j < XC_COMMON_PLACEHOLDER_POOL_SIZE; j++)
+            {
+                empty = XC_COMMON_PLACEHOLDER_EMPTY;
+                if(__atomic_compare_exchange_n(&(xc_common_placeholders[j].state), &empty, XC_COMMON_PLACEHOLDER_FILLING,
+                                               0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                {
+                    slot = &(xc_common_placeholders[j]);
+                    break;
+                }
+            }
+            if(NULL == slot) goto close_dir; //the pool is full
+
+            if((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(placeholder_pathname, XC_COMMON_OPEN_FILE_FLAGS))) < 0)
+            {
+                __atomic_store_n(&(slot->state), XC_COMMON_PLACEHOLDER_EMPTY, __ATOMIC_RELEASE);
+                continue;
+            }
+            slot->fd = fd;
+            strncpy(slot->pathname, placeholder_pathname, sizeof(slot->pathname));
+            slot->pathname[sizeof(slot->pathname) - 1] = '\0';
+            __atomic_store_n(&(slot->state), XC_COMMON_PLACEHOLDER_READY, __ATOMIC_RELEASE);
+        }
+    }
+
+ close_dir:
+    close(dir_fd);
+ end:
+    pthread_mutex_unlock(&xc_common_placeholders_mutex);
+}
+
+//take an opened placeholder file from the pool and rename it (async-signal-safe)
+static int xc_common_take_placeholder(const char *pathname)
+{
+    int    fd, r, ready;
+    size_t i;
+
+    for(i = 0; i < XC_COMMON_PLACEHOLDER_POOL_SIZE; i++)
+    {
+        ready = XC_COMMON_PLACEHOLDER_READY;
+        if(!__atomic_compare_exchange_n(&(xc_common_placeholders[i].state), &ready, XC_COMMON_PLACEHOLDER_TAKEN,
+                                        0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) continue;
+
+        fd = xc_common_placeholders[i].fd;
+        r = rename(xc_common_placeholders[i].pathname, pathname);
+        xc_common_placeholders[i].fd = -1;
+        __atomic_store_n(&(xc_common_placeholders[i].state), XC_COMMON_PLACEHOLDER_EMPTY, __ATOMIC_RELEASE);
+
+        if(0 == r) return fd;
+        close(fd); //it has been deleted or used by the java layer
+    }
+
+    return -1;
+}
+
+//make a clean placeholder file (all zero, blocks allocated) without writing the content,
+//the dirty content (if any) is dropped by truncating, then the blocks are allocated again by fallocate
+int xc_common_provision_placeholder(const char *pathname, size_t size)
+{
+    int fd, r = 0;
+
+    if(NULL == fallocate) return XCC_ERRNO_NOTSPT;
+    if(0 == size || size > INT32_MAX) return XCC_ERRNO_INVAL;
+
+    if((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, O_CREAT | O_WRONLY | O_CLOEXEC, XC_COMMON_OPEN_NEW_FILE_MODE))) < 0) return XCC_ERRNO_SYS;
+
+    errno = 0;
+    if(0 != ftruncate(fd, 0)) r = XCC_ERRNO_SYS;
+    else if(0 != XCC_UTIL_TEMP_FAILURE_RETRY(fallocate(fd, 0, 0, (off_t)size))) r = XCC_ERRNO_SYS; //e.g. EOPNOTSUPP, ENOSPC
+
+    close(fd);
+    return r;
+}
+
+//cut the unused part of the placeholder file, so the file size is the content end
+void xc_common_truncate_log(int fd)
+{
+    off_t offset;
+
+    if((offset = lseek(fd, 0, SEEK_CUR)) > 0) ftruncate(fd, offset);
+}
+
+static int xc_common_open_log(int is_crash, uint64_t timestamp, const char *suffix,
+                              char *pathname, size_t pathname_len)
 {
     int                fd = -1;
     char               buf[512];
@@ -235,8 +386,10 @@ static int xc_common_open_log(int is_crash, uint64_t timestamp,
     xcc_util_dirent_t *ent;
 
     xcc_fmt_snprintf(pathname, pathname_len, "%s/"XC_COMMON_LOG_PREFIX"_%020"PRIu64"_%s__%s%s",
-                     xc_common_log_dir, timestamp, xc_common_app_version, xc_common_process_name,
-                     is_crash ? XC_COMMON_LOG_SUFFIX_CRASH : XC_COMMON_LOG_SUFFIX_TRACE);
+                     xc_common_log_dir, timestamp, xc_common_app_version, xc_common_process_name, suffix);
+
+    //try to take an opened placeholder file from the pool
+    if((fd = xc_common_take_placeholder(pathname)) >= 0) return fd;
 
     //open dir
     if((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xc_common_log_dir, XC_COMMON_OPEN_DIR_FLAGS))) < 0)
@@ -253,17 +406,12 @@ static int xc_common_open_log(int is_crash, uint64_t timestamp,
         {
             ent = (xcc_util_dirent_t *)(buf + i);
             
-            // placeholder_01234567890123456789.clean.xcrash
-            // file name length: 45
-            if(45 == strlen(ent->d_name) &&
-               0 == memcmp(ent->d_name, XC_COMMON_PLACEHOLDER_PREFIX"_", 12) &&
-               0 == memcmp(ent->d_name + 32, XC_COMMON_PLACEHOLDER_SUFFIX, 13))
+            if(xc_common_is_placeholder(ent->d_name))
             {
                 xcc_fmt_snprintf(placeholder_pathname, sizeof(placeholder_pathname), "%s/%s", xc_common_log_dir, ent->d_name);
                 if(0 == rename(placeholder_pathname, pathname))
                 {
                     close(fd);
-                    if(NULL != from_placeholder) *from_placeholder = 1;
                     return XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, XC_COMMON_OPEN_FILE_FLAGS));
                 }
             }
@@ -273,8 +421,6 @@ static int xc_common_open_log(int is_crash, uint64_t timestamp,
     xc_common_open_prepared_fd(is_crash);
     
  create_new_file:
-    if(NULL != from_placeholder) *from_placeholder = 0;
-    
     if((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, XC_COMMON_OPEN_NEW_FILE_FLAGS, XC_COMMON_OPEN_NEW_FILE_MODE))) >= 0) return fd;
 
     //try again with the prepared fd
@@ -284,18 +430,27 @@ static int xc_common_open_log(int is_crash, uint64_t timestamp,
 
 static void xc_common_close_log(int fd, int is_crash)
 {
+    xc_common_truncate_log(fd);
     close(fd);
     xc_common_open_prepared_fd(is_crash);
 }
 
-int xc_common_open_crash_log(char *pathname, size_t pathname_len, int *from_placeholder)
+//the raw crash log is rendered into the final one on the next launch (deferred symbolization)
+int xc_common_open_crash_log(char *pathname, size_t pathname_len, int raw)
 {
-    return xc_common_open_log(1, xc_common_start_time, pathname, pathname_len, from_placeholder);
+    return xc_common_open_log(1, xc_common_start_time, raw ? XC_COMMON_LOG_SUFFIX_CRASH_RAW : XC_COMMON_LOG_SUFFIX_CRASH,
+                              pathname, pathname_len);
 }
 
 int xc_common_open_trace_log(char *pathname, size_t pathname_len, uint64_t trace_time)
 {
-    return xc_common_open_log(0, trace_time, pathname, pathname_len, NULL);
+    return xc_common_open_log(0, trace_time, XC_COMMON_LOG_SUFFIX_TRACE, pathname, pathname_len);
+}
+
+//the snapshot log shares the prepared FD with the trace log
+int xc_common_open_snapshot_log(char *pathname, size_t pathname_len, uint64_t snapshot_time)
+{
+    return xc_common_open_log(0, snapshot_time, XC_COMMON_LOG_SUFFIX_SNAPSHOT, pathname, pathname_len);
 }
 
 void xc_common_close_crash_log(int fd)
@@ -308,44 +463,9 @@ void xc_common_close_trace_log(int fd)
     xc_common_close_log(fd, 0);
 }
 
-int xc_common_seek_to_content_end(int fd)
+void xc_common_close_snapshot_log(int fd)
 {
-    uint8_t buf[1024];
-    ssize_t readed, n;
-    off_t   offset = 0;
-
-    //placeholder file
-    if(lseek(fd, 0, SEEK_SET) < 0) goto err;
-    while(1)
-    {
-        readed = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf)));
-        if(readed < 0)
-        {
-            goto err;
-        }
-        else if(0 == readed)
-        {
-            if(lseek(fd, 0, SEEK_END) < 0) goto err;
-            return fd;
-        }
-        else
-        {
-            for(n = readed; n > 0; n--)
-            {
-                if(0 != buf[n - 1]) break;
-            }
-            offset += (off_t)n;
-            if(n < readed)
-            {
-                if(lseek(fd, offset, SEEK_SET) < 0) goto err;
-                return fd;
-            }
-        }
-    }
-
- err:
-    close(fd);
-    return -1;
+    xc_common_close_log(fd, 0);
 }
 
 #pragma clang diagnostic pop
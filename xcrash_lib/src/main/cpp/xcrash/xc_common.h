@@ -36,12 +36,16 @@ extern "C" {
 // log filename format:
 // tombstone_01234567890123456789_appversion__processname.native.xcrash
 // tombstone_01234567890123456789_appversion__processname.trace.xcrash
+// tombstone_01234567890123456789_appversion__processname.native-snapshot.xcrash
+// tombstone_01234567890123456789_appversion__processname.native-raw.xcrash
 // placeholder_01234567890123456789.clean.xcrash
 #define XC_COMMON_LOG_PREFIX           "tombstone"
 #define XC_COMMON_LOG_PREFIX_LEN       9
 #define XC_COMMON_LOG_SUFFIX_CRASH     ".native.xcrash"
 #define XC_COMMON_LOG_SUFFIX_TRACE     ".trace.xcrash"
 #define XC_COMMON_LOG_SUFFIX_TRACE_LEN 13
+#define XC_COMMON_LOG_SUFFIX_SNAPSHOT  ".native-snapshot.xcrash"
+#define XC_COMMON_LOG_SUFFIX_CRASH_RAW ".native-raw.xcrash"
 #define XC_COMMON_LOG_NAME_MIN_TRACE   (9 + 1 + 20 + 1 + 2 + 13)
 #define XC_COMMON_PLACEHOLDER_PREFIX   "placeholder"
 #define XC_COMMON_PLACEHOLDER_SUFFIX   ".clean.xcrash"
@@ -89,11 +93,16 @@ int xc_common_init(int         api_level,
                    const char *app_lib_dir,
                    const char *log_dir);
 
-int xc_common_open_crash_log(char *pathname, size_t pathname_len, int *from_placeholder);
+void xc_common_fill_placeholder_pool(void);
+int xc_common_provision_placeholder(const char *pathname, size_t size);
+void xc_common_truncate_log(int fd);
+
+int xc_common_open_crash_log(char *pathname, size_t pathname_len, int raw);
 int xc_common_open_trace_log(char *pathname, size_t pathname_len, uint64_t trace_time);
+int xc_common_open_snapshot_log(char *pathname, size_t pathname_len, uint64_t snapshot_time);
 void xc_common_close_crash_log(int fd);
 void xc_common_close_trace_log(int fd);
-int xc_common_seek_to_content_end(int fd);
+void xc_common_close_snapshot_log(int fd);
 
 #ifdef __cplusplus
 }
@@ -40,6 +40,7 @@
 #include <sched.h>
 #include <sys/eventfd.h>
 #include <sys/prctl.h>
+#include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/syscall.h>
@@ -75,7 +76,6 @@ static char            *xc_crash_emergency;
 //the log file
 static int              xc_crash_prepared_fd = -1;
 static int              xc_crash_log_fd  = -1;
-static int              xc_crash_log_from_placeholder;
 static char             xc_crash_log_pathname[1024] = "\0";
 
 //the crash
@@ -98,7 +98,12 @@ static int              xc_crash_child_notifier[2];
 
 //info passed to the dumper process
 static xcc_spot_t       xc_crash_spot;
-static char            *xc_crash_dump_all_threads_allowlist = NULL;
+static struct iovec     xc_crash_args[3]; //spot info, strings serialized at init, log pathname
+static int              xc_crash_args_pipe_size;
+
+//the standby dumper process (spawned in advance, waiting for the args)
+static pid_t            xc_crash_standby_pid = -1;
+static int              xc_crash_standby_fd[2] = {-1, -1};
 
 static int xc_crash_fork(int (*fn)(void *))
 {
@@ -171,49 +176,31 @@ static int xc_crash_exec_dumper(void *arg)
 
     //set args pipe size
     //range: pagesize (4K) ~ /proc/sys/fs/pipe-max-size (1024K)
-    int write_len = (int)(sizeof(xcc_spot_t) +
-                          xc_crash_spot.log_pathname_len +
-                          xc_crash_spot.os_version_len +
-                          xc_crash_spot.kernel_version_len +
-                          xc_crash_spot.abi_list_len +
-                          xc_crash_spot.manufacturer_len +
-                          xc_crash_spot.brand_len +
-                          xc_crash_spot.model_len +
-                          xc_crash_spot.build_fingerprint_len +
-                          xc_crash_spot.app_id_len +
-                          xc_crash_spot.app_version_len +
-                          xc_crash_spot.dump_all_threads_allowlist_len);
     errno = 0;
-    if(fcntl(pipefd[1], F_SETPIPE_SZ, write_len) < write_len)
+    if(fcntl(pipefd[1], F_SETPIPE_SZ, xc_crash_args_pipe_size) < xc_crash_args_pipe_size)
     {
         xcc_util_write_format_safe(xc_crash_log_fd, XC_CRASH_ERR_TITLE"set args pipe size failed, errno=%d\n\n", errno);
         return 93;
     }
 
     //write args to pipe
-    struct iovec iovs[12] = {
-        {.iov_base = &xc_crash_spot,                      .iov_len = sizeof(xcc_spot_t)},
-        {.iov_base = xc_crash_log_pathname,               .iov_len = xc_crash_spot.log_pathname_len},
-        {.iov_base = xc_common_os_version,                .iov_len = xc_crash_spot.os_version_len},
-        {.iov_base = xc_common_kernel_version,            .iov_len = xc_crash_spot.kernel_version_len},
-        {.iov_base = xc_common_abi_list,                  .iov_len = xc_crash_spot.abi_list_len},
-        {.iov_base = xc_common_manufacturer,              .iov_len = xc_crash_spot.manufacturer_len},
-        {.iov_base = xc_common_brand,                     .iov_len = xc_crash_spot.brand_len},
-        {.iov_base = xc_common_model,                     .iov_len = xc_crash_spot.model_len},
-        {.iov_base = xc_common_build_fingerprint,         .iov_len = xc_crash_spot.build_fingerprint_len},
-        {.iov_base = xc_common_app_id,                    .iov_len = xc_crash_spot.app_id_len},
-        {.iov_base = xc_common_app_version,               .iov_len = xc_crash_spot.app_version_len},
-        {.iov_base = xc_crash_dump_all_threads_allowlist, .iov_len = xc_crash_spot.dump_all_threads_allowlist_len}
-    };
-    int iovs_cnt = (0 == xc_crash_spot.dump_all_threads_allowlist_len ? 11 : 12);
+    size_t write_len = xc_crash_args[0].iov_len + xc_crash_args[1].iov_len + xc_crash_args[2].iov_len;
     errno = 0;
-    ssize_t ret = XCC_UTIL_TEMP_FAILURE_RETRY(writev(pipefd[1], iovs, iovs_cnt));
+    ssize_t ret = XCC_UTIL_TEMP_FAILURE_RETRY(writev(pipefd[1], xc_crash_args, 3));
     if((ssize_t)write_len != ret)
     {
         xcc_util_write_format_safe(xc_crash_log_fd, XC_CRASH_ERR_TITLE"write args to pipe failed, return=%d, errno=%d\n\n", ret, errno);
         return 94;
     }
 
+    //the dumper writes to the log file via the same open file description
+    errno = 0;
+    if(0 != fcntl(xc_crash_log_fd, F_SETFD, 0))
+    {
+        xcc_util_write_format_safe(xc_crash_log_fd, XC_CRASH_ERR_TITLE"pass log fd failed, errno=%d\n\n", errno);
+        return 95;
+    }
+
     //copy the read-side of the args-pipe to stdin (fd: 0)
     XCC_UTIL_TEMP_FAILURE_RETRY(dup2(pipefd[0], STDIN_FILENO));
     
@@ -226,6 +213,100 @@ static int xc_crash_exec_dumper(void *arg)
     return 100 + errno;
 }
 
+static int xc_crash_exec_standby_dumper(void *arg)
+{
+    (void)arg;
+
+    //the socket becomes the stdin of the dumper, it blocks on reading the args until a crash occurred
+    if(STDIN_FILENO != xc_crash_standby_fd[1])
+        if(0 > XCC_UTIL_TEMP_FAILURE_RETRY(dup2(xc_crash_standby_fd[1], STDIN_FILENO))) return 90;
+    if(0 != fcntl(STDIN_FILENO, F_SETFD, 0)) return 91;
+
+    //no other inherited fd
+    int i;
+    for(i = 1; i < 1024; i++)
+        syscall(SYS_close, i);
+
+    //hold the fd 1, 2
+    int devnull = XCC_UTIL_TEMP_FAILURE_RETRY(open("/dev/null", O_RDWR));
+    if(STDOUT_FILENO != devnull) return 92;
+    XCC_UTIL_TEMP_FAILURE_RETRY(dup2(devnull, STDERR_FILENO));
+
+    execl(xc_crash_dumper_pathname, XCC_UTIL_XCRASH_DUMPER_FILENAME, XCC_UTIL_XCRASH_DUMPER_STANDBY, NULL);
+    return 100 + errno;
+}
+
+static void xc_crash_spawn_standby_dumper(void)
+{
+    if(0 != socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, xc_crash_standby_fd)) return;
+
+    xc_crash_standby_pid = xc_crash_fork(xc_crash_exec_standby_dumper);
+
+    syscall(SYS_close, xc_crash_standby_fd[1]);
+    xc_crash_standby_fd[1] = -1;
+    if(-1 == xc_crash_standby_pid)
+    {
+        syscall(SYS_close, xc_crash_standby_fd[0]);
+        xc_crash_standby_fd[0] = -1;
+    }
+
+#ifdef __i386__
+    //the notifier pipe has been closed by xc_crash_fork(), re-create it for the crash dumping
+    if(0 != pipe2(xc_crash_child_notifier, O_CLOEXEC))
+    {
+        xc_crash_child_notifier[0] = -1;
+        xc_crash_child_notifier[1] = -1;
+    }
+#endif
+}
+
+//pass the args to the standby dumper process, return its PID, or -1 if it is gone
+static pid_t xc_crash_wake_standby_dumper(void)
+{
+    pid_t         pid = xc_crash_standby_pid;
+    struct msghdr msg;
+    union
+    {
+        struct cmsghdr hdr;
+        char           buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct cmsghdr *cmsg;
+    size_t        len = xc_crash_args[0].iov_len + xc_crash_args[1].iov_len + xc_crash_args[2].iov_len;
+    int           status;
+
+    if(pid <= 0) return -1;
+    xc_crash_standby_pid = -1;
+
+    //is it still alive? (it may have been killed, or reaped by someone else's waitpid())
+    if(0 != XCC_UTIL_TEMP_FAILURE_RETRY(waitpid(pid, &status, WNOHANG | __WALL))) goto err;
+
+    //MSG_NOSIGNAL: get EPIPE instead of SIGPIPE if it has just exited
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov = xc_crash_args;
+    msg.msg_iovlen = 3;
+
+    //pass the log fd along with the args (SCM_RIGHTS)
+    memset(&control, 0, sizeof(control));
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &xc_crash_log_fd, sizeof(int));
+    if((ssize_t)len != XCC_UTIL_TEMP_FAILURE_RETRY(sendmsg(xc_crash_standby_fd[0], &msg, MSG_NOSIGNAL))) goto err;
+
+    syscall(SYS_close, xc_crash_standby_fd[0]);
+    xc_crash_standby_fd[0] = -1;
+    return pid;
+
+ err:
+    //the dumper gets EOF and exits if it is still alive
+    syscall(SYS_close, xc_crash_standby_fd[0]);
+    xc_crash_standby_fd[0] = -1;
+    return -1;
+}
+
 static void xc_xcrash_record_java_stacktrace()
 {
     JNIEnv                           *env     = NULL;
@@ -428,7 +509,8 @@ static void xc_crash_signal_handler(int sig, siginfo_t *si, void *uc)
     xc_crash_tid = gettid();
     
     //create and open log file
-    if((xc_crash_log_fd = xc_common_open_crash_log(xc_crash_log_pathname, sizeof(xc_crash_log_pathname), &xc_crash_log_from_placeholder)) < 0) goto end;
+    if((xc_crash_log_fd = xc_common_open_crash_log(xc_crash_log_pathname, sizeof(xc_crash_log_pathname),
+                                                   xc_crash_spot.defer_symbols)) < 0) goto end;
 
     //check privilege-restricting mode
     //https://www.kernel.org/doc/Documentation/prctl/no_new_privs.txt
@@ -475,14 +557,20 @@ static void xc_crash_signal_handler(int sig, siginfo_t *si, void *uc)
     memcpy(&(xc_crash_spot.siginfo), si, sizeof(siginfo_t));
     memcpy(&(xc_crash_spot.ucontext), uc, sizeof(ucontext_t));
     xc_crash_spot.log_pathname_len = strlen(xc_crash_log_pathname);
+    xc_crash_spot.log_fd = xc_crash_log_fd;
+    xc_crash_args[2].iov_len = xc_crash_spot.log_pathname_len;
 
-    //spawn crash dumper process
-    errno = 0;
-    pid_t dumper_pid = xc_crash_fork(xc_crash_exec_dumper);
+    //wake up the standby crash dumper process, or spawn a new one
+    pid_t dumper_pid = xc_crash_wake_standby_dumper();
     if(-1 == dumper_pid)
     {
-        xcc_util_write_format_safe(xc_crash_log_fd, XC_CRASH_ERR_TITLE"fork failed, errno=%d\n\n", errno);
-        goto end;
+        errno = 0;
+        dumper_pid = xc_crash_fork(xc_crash_exec_dumper);
+        if(-1 == dumper_pid)
+        {
+            xcc_util_write_format_safe(xc_crash_log_fd, XC_CRASH_ERR_TITLE"fork failed, errno=%d\n\n", errno);
+            goto end;
+        }
     }
 
     //parent process ...
@@ -492,12 +580,8 @@ static void xc_crash_signal_handler(int sig, siginfo_t *si, void *uc)
     int status = 0;
     int wait_r = XCC_UTIL_TEMP_FAILURE_RETRY(waitpid(dumper_pid, &status, __WALL));
 
-    //the crash dumper process should have written a lot of logs,
-    //so we need to seek to the end of log file
-    if(xc_crash_log_from_placeholder)
-    {
-        if((xc_crash_log_fd = xc_common_seek_to_content_end(xc_crash_log_fd)) < 0) goto end;
-    }
+    //the crash dumper process wrote the logs via the same open file description,
+    //so the file offset is already at the end of the content (even in a placeholder file)
     
     if(-1 == wait_r)
     {
@@ -559,6 +643,7 @@ static void xc_crash_signal_handler(int sig, siginfo_t *si, void *uc)
                                        xc_crash_spot.dump_fds,
                                        xc_crash_spot.dump_network_info))
             {
+                xc_common_truncate_log(xc_crash_log_fd);
                 close(xc_crash_log_fd);
                 xc_crash_log_fd = -1;
             }
@@ -571,6 +656,8 @@ static void xc_crash_signal_handler(int sig, siginfo_t *si, void *uc)
         xc_xcrash_record_java_stacktrace();
         
         //we have written all the required information in the native layer, close the FD
+        //(the java layer appends its sections at the end of the file)
+        xc_common_truncate_log(xc_crash_log_fd);
         close(xc_crash_log_fd);
         xc_crash_log_fd = -1;
     }
@@ -588,13 +675,96 @@ static void xc_crash_signal_handler(int sig, siginfo_t *si, void *uc)
     _exit(1);
 }
 
-static void xc_crash_init_dump_all_threads_allowlist(const char **allowlist, size_t allowlist_len)
+//dump registers and backtraces of the threads in the running process (no crash)
+int xc_crash_dump_snapshot(char *pathname, size_t pathname_len)
+{
+    struct timespec snapshot_tp;
+    int             orig_dumpable;
+    int             restore_orig_ptracer = 0;
+    int             status = 0;
+    pid_t           dumper_pid;
+    int             r = 0;
+
+    if(NULL == xc_crash_dumper_pathname) return XCC_ERRNO_STATE; //crash capture is not enabled
+
+    //share the log pathname, the dumper's stack and the spot info with the crash handler
+    pthread_mutex_lock(&xc_crash_mutex);
+    if(xc_common_native_crashed)
+    {
+        r = XCC_ERRNO_STATE;
+        goto end;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &snapshot_tp);
+    xc_crash_spot.crash_time = (uint64_t)(snapshot_tp.tv_sec) * 1000 * 1000 + (uint64_t)snapshot_tp.tv_nsec / 1000;
+    xc_crash_spot.crash_tid = gettid();
+    xc_crash_spot.snapshot = 1;
+    memset(&(xc_crash_spot.siginfo), 0, sizeof(siginfo_t));
+    memset(&(xc_crash_spot.ucontext), 0, sizeof(ucontext_t));
+
+    //create and open log file
+    if((xc_crash_log_fd = xc_common_open_snapshot_log(xc_crash_log_pathname, sizeof(xc_crash_log_pathname),
+                                                      xc_crash_spot.crash_time)) < 0)
+    {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+    xc_crash_spot.log_pathname_len = strlen(xc_crash_log_pathname);
+    xc_crash_spot.log_fd = xc_crash_log_fd;
+    xc_crash_args[2].iov_len = xc_crash_spot.log_pathname_len;
+
+    //set dumpable and traceable
+    orig_dumpable = prctl(PR_GET_DUMPABLE);
+    if(0 != prctl(PR_SET_DUMPABLE, 1))
+    {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+    if(0 == prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY)) restore_orig_ptracer = 1;
+
+    //spawn dumper process, and wait for it
+    if(-1 == (dumper_pid = xc_crash_fork(xc_crash_exec_dumper)))
+        r = XCC_ERRNO_SYS;
+    else if(-1 == XCC_UTIL_TEMP_FAILURE_RETRY(waitpid(dumper_pid, &status, __WALL)))
+        r = XCC_ERRNO_SYS;
+    else if(!(WIFEXITED(status)) || 0 != WEXITSTATUS(status))
+        r = XCC_ERRNO_SYS;
+#ifdef __i386__
+    //the notifier pipe has been closed by xc_crash_fork(), re-create it for the next dumping
+    if(0 != pipe2(xc_crash_child_notifier, O_CLOEXEC)) r = XCC_ERRNO_SYS;
+#endif
+
+    prctl(PR_SET_DUMPABLE, orig_dumpable);
+    if(restore_orig_ptracer) prctl(PR_SET_PTRACER, 0);
+
+    if(0 == r)
+    {
+        strncpy(pathname, xc_crash_log_pathname, pathname_len);
+        pathname[pathname_len - 1] = '\0';
+    }
+
+ end:
+    if(xc_crash_log_fd >= 0)
+    {
+        xc_common_close_snapshot_log(xc_crash_log_fd);
+        xc_crash_log_fd = -1;
+    }
+    if(0 != r && '\0' != xc_crash_log_pathname[0]) unlink(xc_crash_log_pathname);
+    xc_crash_log_pathname[0] = '\0';
+    xc_crash_spot.snapshot = 0;
+    xc_crash_spot.crash_tid = 0;
+    xc_crash_spot.crash_time = 0;
+    pthread_mutex_unlock(&xc_crash_mutex);
+    return r;
+}
+
+static char *xc_crash_init_dump_all_threads_allowlist(const char **allowlist, size_t allowlist_len)
 {
     size_t  i, len;
     size_t  encoded_len, total_encoded_len = 0, cur_encoded_len = 0;
     char   *total_encoded_allowlist, *tmp;
     
-    if(NULL == allowlist || 0 == allowlist_len) return;
+    if(NULL == allowlist || 0 == allowlist_len) return NULL;
 
     //get total encoded length
     for(i = 0; i < allowlist_len; i++)
@@ -604,12 +774,12 @@ static void xc_crash_init_dump_all_threads_allowlist(const char **allowlist, siz
         if(0 == len) continue;
         total_encoded_len += xcc_b64_encode_max_len(len);
     }
-    if(0 == total_encoded_len) return;
+    if(0 == total_encoded_len) return NULL;
     total_encoded_len += allowlist_len; //separator ('|')
     total_encoded_len += 1; //terminating null byte ('\0')
 
     //alloc encode buffer
-    if(NULL == (total_encoded_allowlist = calloc(1, total_encoded_len))) return;
+    if(NULL == (total_encoded_allowlist = calloc(1, total_encoded_len))) return NULL;
 
     //to base64 encode each allowlist item
     for(i = 0; i < allowlist_len; i++)
@@ -620,7 +790,7 @@ static void xc_crash_init_dump_all_threads_allowlist(const char **allowlist, siz
 
         if(NULL != (tmp = xcc_b64_encode((const uint8_t *)(allowlist[i]), len, &encoded_len)))
         {
-            if(cur_encoded_len + encoded_len + 1 >= total_encoded_len) return; //impossible
+            if(cur_encoded_len + encoded_len + 1 >= total_encoded_len) return NULL; //impossible
             
             memcpy(total_encoded_allowlist + cur_encoded_len, tmp, encoded_len);
             cur_encoded_len += encoded_len;
@@ -641,11 +811,82 @@ static void xc_crash_init_dump_all_threads_allowlist(const char **allowlist, siz
     if(0 == cur_encoded_len)
     {
         free(total_encoded_allowlist);
-        return;
+        return NULL;
     }
 
     xc_crash_spot.dump_all_threads_allowlist_len = cur_encoded_len;
-    xc_crash_dump_all_threads_allowlist = total_encoded_allowlist;
+    return total_encoded_allowlist;
+}
+
+//serialize the strings passed to the dumper process once, only the spot info and the log pathname are set when crashed
+static int xc_crash_init_args(const char **dump_all_threads_allowlist, size_t dump_all_threads_allowlist_len)
+{
+    char   *allowlist = xc_crash_init_dump_all_threads_allowlist(dump_all_threads_allowlist, dump_all_threads_allowlist_len);
+    char   *buf, *cur;
+    size_t  len;
+
+    xc_crash_spot.os_version_len = strlen(xc_common_os_version);
+    xc_crash_spot.kernel_version_len = strlen(xc_common_kernel_version);
+    xc_crash_spot.abi_list_len = strlen(xc_common_abi_list);
+    xc_crash_spot.manufacturer_len = strlen(xc_common_manufacturer);
+    xc_crash_spot.brand_len = strlen(xc_common_brand);
+    xc_crash_spot.model_len = strlen(xc_common_model);
+    xc_crash_spot.build_fingerprint_len = strlen(xc_common_build_fingerprint);
+    xc_crash_spot.app_id_len = strlen(xc_common_app_id);
+    xc_crash_spot.app_version_len = strlen(xc_common_app_version);
+
+    len = xc_crash_spot.os_version_len +
+          xc_crash_spot.kernel_version_len +
+          xc_crash_spot.abi_list_len +
+          xc_crash_spot.manufacturer_len +
+          xc_crash_spot.brand_len +
+          xc_crash_spot.model_len +
+          xc_crash_spot.build_fingerprint_len +
+          xc_crash_spot.app_id_len +
+          xc_crash_spot.app_version_len +
+          xc_crash_spot.dump_all_threads_allowlist_len;
+    if(NULL == (buf = malloc(len)))
+    {
+        free(allowlist);
+        return XCC_ERRNO_NOMEM;
+    }
+
+    //the same order as the dumper reads them
+    cur = buf;
+    memcpy(cur, xc_common_os_version, xc_crash_spot.os_version_len);
+    cur += xc_crash_spot.os_version_len;
+    memcpy(cur, xc_common_kernel_version, xc_crash_spot.kernel_version_len);
+    cur += xc_crash_spot.kernel_version_len;
+    memcpy(cur, xc_common_abi_list, xc_crash_spot.abi_list_len);
+    cur += xc_crash_spot.abi_list_len;
+    memcpy(cur, xc_common_manufacturer, xc_crash_spot.manufacturer_len);
+    cur += xc_crash_spot.manufacturer_len;
+    memcpy(cur, xc_common_brand, xc_crash_spot.brand_len);
+    cur += xc_crash_spot.brand_len;
+    memcpy(cur, xc_common_model, xc_crash_spot.model_len);
+    cur += xc_crash_spot.model_len;
+    memcpy(cur, xc_common_build_fingerprint, xc_crash_spot.build_fingerprint_len);
+    cur += xc_crash_spot.build_fingerprint_len;
+    memcpy(cur, xc_common_app_id, xc_crash_spot.app_id_len);
+    cur += xc_crash_spot.app_id_len;
+    memcpy(cur, xc_common_app_version, xc_crash_spot.app_version_len);
+    cur += xc_crash_spot.app_version_len;
+    if(NULL != allowlist)
+    {
+        memcpy(cur, allowlist, xc_crash_spot.dump_all_threads_allowlist_len);
+        free(allowlist);
+    }
+
+    xc_crash_args[0].iov_base = &xc_crash_spot;
+    xc_crash_args[0].iov_len = sizeof(xcc_spot_t);
+    xc_crash_args[1].iov_base = buf;
+    xc_crash_args[1].iov_len = len;
+    xc_crash_args[2].iov_base = xc_crash_log_pathname;
+    xc_crash_args[2].iov_len = 0;
+
+    //range: pagesize (4K) ~ /proc/sys/fs/pipe-max-size (1024K)
+    xc_crash_args_pipe_size = (int)(sizeof(xcc_spot_t) + len + sizeof(xc_crash_log_pathname));
+    return 0;
 }
 
 static void xc_crash_init_callback(JNIEnv *env)
@@ -681,8 +922,13 @@ int xc_crash_init(JNIEnv *env,
                   int dump_all_threads,
                   unsigned int dump_all_threads_count_max,
                   const char **dump_all_threads_allowlist,
-                  size_t dump_all_threads_allowlist_len)
+                  size_t dump_all_threads_allowlist_len,
+                  int dump_binary,
+                  int standby_dumper,
+                  int defer_symbols)
 {
+    int r;
+
     xc_crash_prepared_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open("/dev/null", O_RDWR));
     xc_crash_rethrow = rethrow;
     if(NULL == (xc_crash_emergency = calloc(XC_CRASH_EMERGENCY_BUF_LEN, 1))) return XCC_ERRNO_NOMEM;
@@ -709,16 +955,9 @@ int xc_crash_init(JNIEnv *env,
     xc_crash_spot.dump_network_info = dump_network_info;
     xc_crash_spot.dump_all_threads = dump_all_threads;
     xc_crash_spot.dump_all_threads_count_max = dump_all_threads_count_max;
-    xc_crash_spot.os_version_len = strlen(xc_common_os_version);
-    xc_crash_spot.kernel_version_len = strlen(xc_common_kernel_version);
-    xc_crash_spot.abi_list_len = strlen(xc_common_abi_list);
-    xc_crash_spot.manufacturer_len = strlen(xc_common_manufacturer);
-    xc_crash_spot.brand_len = strlen(xc_common_brand);
-    xc_crash_spot.model_len = strlen(xc_common_model);
-    xc_crash_spot.build_fingerprint_len = strlen(xc_common_build_fingerprint);
-    xc_crash_spot.app_id_len = strlen(xc_common_app_id);
-    xc_crash_spot.app_version_len = strlen(xc_common_app_version);
-    xc_crash_init_dump_all_threads_allowlist(dump_all_threads_allowlist, dump_all_threads_allowlist_len);
+    xc_crash_spot.dump_binary = dump_binary;
+    xc_crash_spot.defer_symbols = defer_symbols;
+    if(0 != (r = xc_crash_init_args(dump_all_threads_allowlist, dump_all_threads_allowlist_len))) return r;
 
     //for clone and fork
 #ifndef __i386__
@@ -727,6 +966,9 @@ int xc_crash_init(JNIEnv *env,
 #else
     if(0 != pipe2(xc_crash_child_notifier, O_CLOEXEC)) return XCC_ERRNO_SYS;
 #endif
+
+    //spawn the crash dumper process in advance (no fork and exec at crash time)
+    if(standby_dumper) xc_crash_spawn_standby_dumper();
     
     //register signal handler
     return xcc_signal_crash_register(xc_crash_signal_handler);
@@ -33,6 +33,8 @@
 extern "C" {
 #endif
 
+int xc_crash_dump_snapshot(char *pathname, size_t pathname_len);
+
 int xc_crash_init(JNIEnv *env,
                   int rethrow,
                   unsigned int logcat_system_lines,
@@ -45,7 +47,10 @@ int xc_crash_init(JNIEnv *env,
                   int dump_all_threads,
                   unsigned int dump_all_threads_count_max,
                   const char **dump_all_threads_allowlist,
-                  size_t dump_all_threads_allowlist_len);
+                  size_t dump_all_threads_allowlist_len,
+                  int dump_binary,
+                  int standby_dumper,
+                  int defer_symbols);
 
 #ifdef __cplusplus
 }
@@ -69,6 +69,9 @@ static jint xc_jni_init(JNIEnv       *env,
                         jboolean      crash_dump_all_threads,
                         jint          crash_dump_all_threads_count_max,
                         jobjectArray  crash_dump_all_threads_allowlist,
+                        jboolean      crash_dump_binary,
+                        jboolean      crash_standby_dumper,
+                        jboolean      crash_defer_symbols,
                         jboolean      trace_enable,
                         jboolean      trace_rethrow,
                         jint          trace_logcat_system_lines,
@@ -173,7 +176,10 @@ static jint xc_jni_init(JNIEnv       *env,
                                 crash_dump_all_threads ? 1 : 0,
                                 (unsigned int)crash_dump_all_threads_count_max,
                                 c_crash_dump_all_threads_allowlist,
-                                c_crash_dump_all_threads_allowlist_len);
+                                c_crash_dump_all_threads_allowlist_len,
+                                crash_dump_binary ? 1 : 0,
+                                crash_standby_dumper ? 1 : 0,
+                                crash_defer_symbols ? 1 : 0);
     }
     
     if(trace_enable)
@@ -230,6 +236,39 @@ static void xc_jni_test_crash(JNIEnv *env, jobject thiz, jint run_in_new_thread)
     xc_test_crash(run_in_new_thread);
 }
 
+static jstring xc_jni_dump_snapshot(JNIEnv *env, jobject thiz)
+{
+    char pathname[1024];
+
+    (void)thiz;
+
+    if(0 != xc_crash_dump_snapshot(pathname, sizeof(pathname))) return NULL;
+    return (*env)->NewStringUTF(env, pathname);
+}
+
+static void xc_jni_fill_placeholder_pool(JNIEnv *env, jobject thiz)
+{
+    (void)env;
+    (void)thiz;
+
+    xc_common_fill_placeholder_pool();
+}
+
+static jboolean xc_jni_provision_placeholder(JNIEnv *env, jobject thiz, jstring pathname, jlong size)
+{
+    const char *c_pathname;
+    int         r;
+
+    (void)thiz;
+
+    if(!pathname || size <= 0) return JNI_FALSE;
+    if(NULL == (c_pathname = (*env)->GetStringUTFChars(env, pathname, 0))) return JNI_FALSE;
+    r = xc_common_provision_placeholder(c_pathname, (size_t)size);
+    (*env)->ReleaseStringUTFChars(env, pathname, c_pathname);
+
+    return 0 == r ? JNI_TRUE : JNI_FALSE;
+}
+
 static JNINativeMethod xc_jni_methods[] = {
     {
         "nativeInit",
@@ -259,6 +298,9 @@ static JNINativeMethod xc_jni_methods[] = {
         "[Ljava/lang/String;"
         "Z"
         "Z"
+        "Z"
+        "Z"
+        "Z"
         "I"
         "I"
         "I"
@@ -282,6 +324,29 @@ static JNINativeMethod xc_jni_methods[] = {
         ")"
         "V",
         (void *)xc_jni_test_crash
+    },
+    {
+        "nativeDumpSnapshot",
+        "("
+        ")"
+        "Ljava/lang/String;",
+        (void *)xc_jni_dump_snapshot
+    },
+    {
+        "nativeFillPlaceholderPool",
+        "("
+        ")"
+        "V",
+        (void *)xc_jni_fill_placeholder_pool
+    },
+    {
+        "nativeProvisionPlaceholder",
+        "("
+        "Ljava/lang/String;"
+        "J"
+        ")"
+        "Z",
+        (void *)xc_jni_provision_placeholder
     }
 };
 
@@ -0,0 +1,207 @@
+// Copyright (c) 2020-present, HexHacking Team. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "xcc_util.h"
+#include "xcd_arena.h"
+
+#define XCD_ARENA_CHUNK_SIZE  (1024 * 1024)
+#define XCD_ARENA_CAP         (64 * 1024 * 1024)
+#define XCD_ARENA_ALIGN       16
+#define XCD_ARENA_HEAP_HEADER XCD_ARENA_ALIGN //keeps the size of a heap block, and the alignment of the returned pointer
+
+static uint8_t *xcd_arena_chunk      = NULL; //current chunk
+static size_t   xcd_arena_chunk_used = 0;
+static size_t   xcd_arena_chunk_size = 0;
+static size_t   xcd_arena_used       = 0; //bytes returned to the callers (high-water mark, nothing is freed)
+static size_t   xcd_arena_mapped     = 0; //bytes mapped
+static size_t   xcd_arena_heap       = 0; //bytes currently held by the heap blocks (including the headers)
+static size_t   xcd_arena_heap_peak  = 0; //high-water mark of xcd_arena_heap
+static size_t   xcd_arena_failed     = 0; //number of failed allocations
+
+static void *xcd_arena_map(size_t size)
+{
+    void *p;
+    
+    if(size > XCD_ARENA_CAP - xcd_arena_mapped - xcd_arena_heap) return NULL; //hard cap
+    
+    if(MAP_FAILED == (p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))) return NULL;
+    xcd_arena_mapped += size;
+    return p;
+}
+
+void *xcd_arena_alloc(size_t size)
+{
+    size_t  page_size = (size_t)getpagesize();
+    void   *p;
+
+    if(0 == size) size = 1;
+    if(size > XCD_ARENA_CAP) goto err;
+    size = (size + XCD_ARENA_ALIGN - 1) & ~((size_t)XCD_ARENA_ALIGN - 1);
+
+    //bump in the current chunk
+    if(NULL != xcd_arena_chunk && size <= xcd_arena_chunk_size - xcd_arena_chunk_used)
+    {
+        p = xcd_arena_chunk + xcd_arena_chunk_used;
+        xcd_arena_chunk_used += size;
+        xcd_arena_used += size;
+        return p;
+    }
+
+    //big object, give it its own mapping, keep using the current chunk
+    if(size > XCD_ARENA_CHUNK_SIZE / 4)
+    {
+        if(NULL == (p = xcd_arena_map((size + page_size - 1) & ~(page_size - 1)))) goto err;
+        xcd_arena_used += size;
+        return p;
+    }
+
+    //new chunk (the rest of the current chunk is wasted)
+    if(NULL == (p = xcd_arena_map(XCD_ARENA_CHUNK_SIZE))) goto err;
+    xcd_arena_chunk = (uint8_t *)p;
+    xcd_arena_chunk_size = XCD_ARENA_CHUNK_SIZE;
+    xcd_arena_chunk_used = size;
+    xcd_arena_used += size;
+    return p;
+
+ err:
+    xcd_arena_failed++;
+    return NULL;
+}
+
+void *xcd_arena_calloc(size_t nmemb, size_t size)
+{
+    size_t total;
+
+    if(__builtin_mul_overflow(nmemb, size, &total))
+    {
+        xcd_arena_failed++;
+        return NULL;
+    }
+    
+    //anonymous mappings are zero-filled, and the memory is never reused
+    return xcd_arena_alloc(total);
+}
+
+char *xcd_arena_strdup(const char *s)
+{
+    size_t  len = strlen(s) + 1;
+    char   *p;
+
+    if(NULL == (p = xcd_arena_alloc(len))) return NULL;
+    memcpy(p, s, len);
+    return p;
+}
+
+void *xcd_arena_heap_malloc(size_t size)
+{
+    return xcd_arena_heap_realloc(NULL, size);
+}
+
+void *xcd_arena_heap_calloc(size_t nmemb, size_t size)
+{
+    size_t  total;
+    void   *p;
+
+    if(__builtin_mul_overflow(nmemb, size, &total))
+    {
+        xcd_arena_failed++;
+        return NULL;
+    }
+
+    if(NULL == (p = xcd_arena_heap_realloc(NULL, total))) return NULL;
+    memset(p, 0, total);
+    return p;
+}
+
+void *xcd_arena_heap_realloc(void *ptr, size_t size)
+{
+    uint8_t *block = (NULL == ptr ? NULL : (uint8_t *)ptr - XCD_ARENA_HEAP_HEADER);
+    size_t   old_size = 0;
+
+    if(NULL != block) memcpy(&old_size, block, sizeof(old_size));
+
+    if(size > XCD_ARENA_CAP) goto err;
+    size += XCD_ARENA_HEAP_HEADER;
+    if(size > old_size && size - old_size > XCD_ARENA_CAP - xcd_arena_mapped - xcd_arena_heap) goto err; //hard cap
+
+    if(NULL == (block = realloc(block, size))) goto err;
+    memcpy(block, &size, sizeof(size));
+
+    xcd_arena_heap = xcd_arena_heap - old_size + size;
+    if(xcd_arena_heap > xcd_arena_heap_peak) xcd_arena_heap_peak = xcd_arena_heap;
+    return block + XCD_ARENA_HEAP_HEADER;
+
+ err:
+    xcd_arena_failed++;
+    return NULL;
+}
+
+char *xcd_arena_heap_strdup(const char *s)
+{
+    size_t  len = strlen(s) + 1;
+    char   *p;
+
+    if(NULL == (p = xcd_arena_heap_realloc(NULL, len))) return NULL;
+    memcpy(p, s, len);
+    return p;
+}
+
+void xcd_arena_heap_free(void *ptr)
+{
+    uint8_t *block;
+    size_t   size;
+
+    if(NULL == ptr) return;
+
+    block = (uint8_t *)ptr - XCD_ARENA_HEAP_HEADER;
+    memcpy(&size, block, sizeof(size));
+    xcd_arena_heap -= size;
+    free(block);
+}
+
+int xcd_arena_is_full(void)
+{
+    return (xcd_arena_failed > 0 ? 1 : 0);
+}
+
+void xcd_arena_get_stats(size_t *used, size_t *mapped, size_t *heap, size_t *heap_peak, size_t *cap, size_t *failed)
+{
+    if(NULL != used)      *used      = xcd_arena_used;
+    if(NULL != mapped)    *mapped    = xcd_arena_mapped;
+    if(NULL != heap)      *heap      = xcd_arena_heap;
+    if(NULL != heap_peak) *heap_peak = xcd_arena_heap_peak;
+    if(NULL != cap)       *cap       = XCD_ARENA_CAP;
+    if(NULL != failed)    *failed    = xcd_arena_failed;
+}
+
+//async-signal-safe
+int xcd_arena_record(int log_fd)
+{
+    return xcc_util_write_format_safe(log_fd, "dumper arena: used %zu, mapped %zu, heap %zu, heap peak %zu, cap %zu, failed %zu\n",
+                                      xcd_arena_used, xcd_arena_mapped, xcd_arena_heap, xcd_arena_heap_peak,
+                                      (size_t)XCD_ARENA_CAP, xcd_arena_failed);
+}
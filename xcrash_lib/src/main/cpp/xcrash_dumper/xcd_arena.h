@@ -0,0 +1,54 @@
+// Copyright (c) 2020-present, HexHacking Team. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef XCD_ARENA_H
+#define XCD_ARENA_H 1
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//bump allocator for objects which live until the dumper exits (no free)
+//the returned memory is always zero-filled
+void *xcd_arena_alloc(size_t size);
+void *xcd_arena_calloc(size_t nmemb, size_t size);
+char *xcd_arena_strdup(const char *s);
+
+//heap memory which can be resized or freed (caches, indexes, buffers),
+//the live bytes are counted against the same cap as the arena
+void *xcd_arena_heap_malloc(size_t size);
+void *xcd_arena_heap_calloc(size_t nmemb, size_t size);
+void *xcd_arena_heap_realloc(void *ptr, size_t size);
+char *xcd_arena_heap_strdup(const char *s);
+void xcd_arena_heap_free(void *ptr);
+
+int xcd_arena_is_full(void);
+void xcd_arena_get_stats(size_t *used, size_t *mapped, size_t *heap, size_t *heap_peak, size_t *cap, size_t *failed);
+int xcd_arena_record(int log_fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
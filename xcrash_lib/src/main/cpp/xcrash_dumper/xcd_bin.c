@@ -0,0 +1,644 @@
+// Copyright (c) 2020-present, HexHacking Team. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcd_bin.h"
+#include "xcd_arena.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+
+#define XCD_BIN_BUF_SIZE  (64 * 1024)
+#define XCD_BIN_REC_SIZE  (4 * 1024) //max payload size of a record
+#define XCD_BIN_STR_MAX   1024       //longer strings are truncated
+
+static int     xcd_bin_fd = -1;
+static uint8_t xcd_bin_buf[XCD_BIN_BUF_SIZE];
+static size_t  xcd_bin_buf_len = 0;
+static uint8_t xcd_bin_rec[XCD_BIN_REC_SIZE];
+static size_t  xcd_bin_rec_len = 0;
+
+static void xcd_bin_put_uleb128(uint64_t value)
+{
+    uint8_t byte;
+
+    do
+    {
+        byte = (uint8_t)(value & 0x7f);
+        value >>= 7;
+        if(0 != value) byte |= 0x80;
+        if(xcd_bin_rec_len < sizeof(xcd_bin_rec)) xcd_bin_rec[xcd_bin_rec_len++] = byte;
+    } while(0 != value);
+}
+
+static void xcd_bin_put_bytes(const void *data, size_t len)
+{
+    if(len > XCD_BIN_STR_MAX) len = XCD_BIN_STR_MAX;
+    if(xcd_bin_rec_len + 10 + len > sizeof(xcd_bin_rec)) len = 0; //never happens with the existing records
+    
+    xcd_bin_put_uleb128(len);
+    if(len > 0) memcpy(xcd_bin_rec + xcd_bin_rec_len, data, len);
+    xcd_bin_rec_len += len;
+}
+
+static void xcd_bin_put_str(const char *str)
+{
+    if(NULL == str) str = "";
+    xcd_bin_put_bytes(str, strlen(str));
+}
+
+static void xcd_bin_append(const void *data, size_t len)
+{
+    if(len > sizeof(xcd_bin_buf) - xcd_bin_buf_len) xcd_bin_flush();
+    memcpy(xcd_bin_buf + xcd_bin_buf_len, data, len);
+    xcd_bin_buf_len += len;
+}
+
+static void xcd_bin_begin_record(void)
+{
+    xcd_bin_rec_len = 0;
+}
+
+static void xcd_bin_end_record(unsigned int type)
+{
+    uint8_t *payload     = xcd_bin_rec;
+    size_t   payload_len = xcd_bin_rec_len;
+    uint8_t  head[20];
+    size_t   head_len;
+
+    //encode the record head after the payload, then move it to the file buffer
+    if(payload_len > sizeof(xcd_bin_rec) - sizeof(head)) return;
+    xcd_bin_put_uleb128(type);
+    xcd_bin_put_uleb128(payload_len);
+    head_len = xcd_bin_rec_len - payload_len;
+    memcpy(head, payload + payload_len, head_len);
+
+    xcd_bin_append(head, head_len);
+    xcd_bin_append(payload, payload_len);
+}
+
+int xcd_bin_open(const char *log_pathname)
+{
+    char    pathname[1024];
+    size_t  len = strlen(log_pathname);
+    uint8_t head[6];
+
+    if(xcd_bin_fd >= 0) return XCC_ERRNO_STATE;
+
+    //tombstone_xxx.native.xcrash -> tombstone_xxx.native.xcbin
+    if(len > 7 && 0 == memcmp(log_pathname + len - 7, ".xcrash", 7)) len -= 7;
+    if(len + sizeof(XCD_BIN_SUFFIX) > sizeof(pathname)) return XCC_ERRNO_NOSPACE;
+    memcpy(pathname, log_pathname, len);
+    memcpy(pathname + len, XCD_BIN_SUFFIX, sizeof(XCD_BIN_SUFFIX));
+
+    if(0 > (xcd_bin_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, O_CREAT | O_WRONLY | O_CLOEXEC | O_TRUNC,
+                                                          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)))) return XCC_ERRNO_SYS;
+
+    memcpy(head, XCD_BIN_MAGIC, 4);
+    head[4] = XCD_BIN_VERSION;
+    head[5] = (uint8_t)sizeof(uintptr_t);
+    xcd_bin_buf_len = 0;
+    xcd_bin_append(head, sizeof(head));
+    return 0;
+}
+
+int xcd_bin_is_opened(void)
+{
+    return xcd_bin_fd >= 0 ? 1 : 0;
+}
+
+//async-signal-safe
+void xcd_bin_flush(void)
+{
+    if(xcd_bin_fd < 0 || 0 == xcd_bin_buf_len) return;
+    
+    xcc_util_write(xcd_bin_fd, (const char *)xcd_bin_buf, xcd_bin_buf_len);
+    xcd_bin_buf_len = 0;
+}
+
+void xcd_bin_close(void)
+{
+    if(xcd_bin_fd < 0) return;
+
+    xcd_bin_begin_record();
+    xcd_bin_end_record(XCD_BIN_REC_END);
+    xcd_bin_flush();
+    close(xcd_bin_fd);
+    xcd_bin_fd = -1;
+}
+
+//the header lines are in the format of: key: 'value'
+void xcd_bin_record_header(const char *header)
+{
+    const char *line = header, *line_end, *sep;
+
+    if(xcd_bin_fd < 0) return;
+    
+    for(; '\0' != *line; line = ('\0' == *line_end ? line_end : line_end + 1))
+    {
+        if(NULL == (line_end = strchr(line, '\n'))) line_end = line + strlen(line);
+        if(line_end - line < 5 || '\'' != *(line_end - 1)) continue;
+        if(NULL == (sep = strstr(line, ": '")) || sep + 3 > line_end - 1) continue;
+
+        xcd_bin_begin_record();
+        xcd_bin_put_bytes(line, (size_t)(sep - line));
+        xcd_bin_put_bytes(sep + 3, (size_t)(line_end - 1 - (sep + 3)));
+        xcd_bin_end_record(XCD_BIN_REC_HEADER_ITEM);
+    }
+}
+
+void xcd_bin_record_map(uintptr_t start, uintptr_t end, size_t offset, unsigned int flags,
+                        size_t elf_start_offset, uintptr_t load_bias, const char *name)
+{
+    if(xcd_bin_fd < 0) return;
+
+    xcd_bin_begin_record();
+    xcd_bin_put_uleb128(start);
+    xcd_bin_put_uleb128(end);
+    xcd_bin_put_uleb128(offset);
+    xcd_bin_put_uleb128(flags);
+    xcd_bin_put_uleb128(elf_start_offset);
+    xcd_bin_put_uleb128(load_bias);
+    xcd_bin_put_str((flags & XCD_BIN_MAP_FLAG_SAME_NAME) ? NULL : name);
+    xcd_bin_end_record(XCD_BIN_REC_MAP);
+}
+
+void xcd_bin_record_load_bias(size_t map, uintptr_t load_bias)
+{
+    if(xcd_bin_fd < 0) return;
+
+    xcd_bin_begin_record();
+    xcd_bin_put_uleb128(map);
+    xcd_bin_put_uleb128(load_bias);
+    xcd_bin_end_record(XCD_BIN_REC_LOAD_BIAS);
+}
+
+void xcd_bin_record_thread(pid_t pid, pid_t tid, int crashed, const char *tname, const char *pname)
+{
+    if(xcd_bin_fd < 0) return;
+
+    xcd_bin_begin_record();
+    xcd_bin_put_uleb128((uint64_t)pid);
+    xcd_bin_put_uleb128((uint64_t)tid);
+    xcd_bin_put_uleb128(crashed ? 1 : 0);
+    xcd_bin_put_str(tname);
+    xcd_bin_put_str(pname);
+    xcd_bin_end_record(XCD_BIN_REC_THREAD);
+}
+
+void xcd_bin_record_frame(size_t num, uintptr_t pc, uintptr_t rel_pc, size_t map,
+                          size_t func_offset, const char *func_name, const char *so_name)
+{
+    if(xcd_bin_fd < 0) return;
+
+    xcd_bin_begin_record();
+    xcd_bin_put_uleb128(num);
+    xcd_bin_put_uleb128(pc);
+    xcd_bin_put_uleb128(rel_pc);
+    xcd_bin_put_uleb128(map);
+    xcd_bin_put_uleb128(func_offset);
+    xcd_bin_put_str(func_name);
+    xcd_bin_put_str(so_name);
+    xcd_bin_end_record(XCD_BIN_REC_FRAME);
+}
+
+void xcd_bin_record_build_id(size_t map, const uint8_t *build_id, size_t build_id_len, const char *detail)
+{
+    if(xcd_bin_fd < 0) return;
+
+    xcd_bin_begin_record();
+    xcd_bin_put_uleb128(map);
+    xcd_bin_put_bytes(build_id, build_id_len);
+    xcd_bin_put_str(detail);
+    xcd_bin_end_record(XCD_BIN_REC_BUILD_ID);
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    const uint8_t *cur;
+    const uint8_t *end;
+    int            error;
+} xcd_bin_reader_t;
+
+typedef struct
+{
+    uint64_t    start;
+    uint64_t    end;
+    uint64_t    offset;
+    uint64_t    flags;
+    uint64_t    elf_start_offset;
+    uint64_t    load_bias;
+    const char *name;
+    int         name_len;
+} xcd_bin_map_t;
+
+typedef struct
+{
+    int            out_fd;
+    int            addr_width;
+    xcd_bin_map_t *maps;
+    size_t         maps_num;
+    int            in_thread;
+    int            in_crashed_thread;
+    int            in_backtrace;
+    int            in_build_id;
+    size_t         other_threads;
+} xcd_bin_decoder_t;
+#pragma clang diagnostic pop
+
+static uint64_t xcd_bin_get_uleb128(xcd_bin_reader_t *reader)
+{
+    uint64_t value = 0;
+    unsigned shift = 0;
+    uint8_t  byte;
+
+    do
+    {
+        if(reader->cur >= reader->end || shift >= 64)
+        {
+            reader->error = 1;
+            return 0;
+        }
+        byte = *(reader->cur++);
+        value |= ((uint64_t)(byte & 0x7f) << shift);
+        shift += 7;
+    } while(byte & 0x80);
+    
+    return value;
+}
+
+static const char *xcd_bin_get_bytes(xcd_bin_reader_t *reader, int *len)
+{
+    const char *data;
+    uint64_t    n = xcd_bin_get_uleb128(reader);
+
+    if(reader->error || n > (uint64_t)(reader->end - reader->cur) || n > XCD_BIN_STR_MAX)
+    {
+        reader->error = 1;
+        *len = 0;
+        return "";
+    }
+    data = (const char *)reader->cur;
+    reader->cur += n;
+    *len = (int)n;
+    return data;
+}
+
+static xcd_bin_map_t *xcd_bin_decoder_get_map(xcd_bin_decoder_t *self, uint64_t map)
+{
+    return (0 == map || map > self->maps_num) ? NULL : &(self->maps[map - 1]);
+}
+
+static int xcd_bin_decoder_load_maps(xcd_bin_decoder_t *self, const uint8_t *data, size_t len)
+{
+    xcd_bin_reader_t  reader = {data, data + len, 0};
+    xcd_bin_reader_t  payload;
+    xcd_bin_map_t    *map, *prev = NULL;
+    uint64_t          type, payload_len, load_bias;
+    size_t            cnt = 0;
+    int               pass;
+
+    for(pass = 0; pass < 2; pass++)
+    {
+        reader.cur = data;
+        reader.error = 0;
+        while(reader.cur < reader.end)
+        {
+            type = xcd_bin_get_uleb128(&reader);
+            payload_len = xcd_bin_get_uleb128(&reader);
+            if(reader.error || payload_len > (uint64_t)(reader.end - reader.cur)) break; //truncated
+            payload.cur = reader.cur;
+            payload.end = reader.cur + payload_len;
+            payload.error = 0;
+            reader.cur += payload_len;
+
+            //the LOAD_BIAS records follow the map table
+            if(XCD_BIN_REC_LOAD_BIAS == type && 1 == pass)
+            {
+                map = xcd_bin_decoder_get_map(self, xcd_bin_get_uleb128(&payload));
+                load_bias = xcd_bin_get_uleb128(&payload);
+                if(NULL != map && !payload.error) map->load_bias = load_bias;
+                continue;
+            }
+            if(XCD_BIN_REC_MAP != type) continue;
+
+            if(0 == pass)
+            {
+                cnt++;
+                continue;
+            }
+            if(self->maps_num >= cnt) break;
+            map = &(self->maps[self->maps_num++]);
+            map->start            = xcd_bin_get_uleb128(&payload);
+            map->end              = xcd_bin_get_uleb128(&payload);
+            map->offset           = xcd_bin_get_uleb128(&payload);
+            map->flags            = xcd_bin_get_uleb128(&payload);
+            map->elf_start_offset = xcd_bin_get_uleb128(&payload);
+            map->load_bias        = xcd_bin_get_uleb128(&payload);
+            map->name             = xcd_bin_get_bytes(&payload, &(map->name_len));
+            if((map->flags & XCD_BIN_MAP_FLAG_SAME_NAME) && NULL != prev)
+            {
+                map->name     = prev->name;
+                map->name_len = prev->name_len;
+            }
+            prev = map;
+        }
+        if(0 == pass && cnt > 0)
+            if(NULL == (self->maps = xcd_arena_heap_calloc(cnt, sizeof(xcd_bin_map_t)))) return XCC_ERRNO_NOMEM;
+    }
+    return 0;
+}
+
+static int xcd_bin_decoder_render_maps(xcd_bin_decoder_t *self)
+{
+    xcd_bin_map_t *map;
+    uint64_t       size, total_size = 0, max_size = 0, max_offset = 0;
+    int            width_size = 0, width_offset = 0;
+    char           load_bias_buf[64];
+    size_t         i;
+    int            r;
+
+    for(i = 0; i < self->maps_num; i++)
+    {
+        map = &(self->maps[i]);
+        if(map->end - map->start > max_size) max_size = map->end - map->start;
+        if(map->offset > max_offset) max_offset = map->offset;
+    }
+    for(; 0 != max_size; max_size /= 0x10) width_size++;
+    if(0 == width_size) width_size = 1;
+    for(; 0 != max_offset; max_offset /= 0x10) width_offset++;
+    if(0 == width_offset) width_offset = 1;
+
+    if(0 != (r = xcc_util_write_str(self->out_fd, "memory map:\n"))) return r;
+    for(i = 0; i < self->maps_num; i++)
+    {
+        map = &(self->maps[i]);
+        
+        if(0 != map->load_bias)
+            snprintf(load_bias_buf, sizeof(load_bias_buf), " (load bias 0x%"PRIx64")", map->load_bias);
+        else
+            load_bias_buf[0] = '\0';
+
+        size = map->end - map->start;
+        total_size += size;
+
+        if(0 != (r = xcc_util_write_format(self->out_fd, "    %0*"PRIx64"-%0*"PRIx64" %c%c%c %*"PRIx64" %*"PRIx64" %.*s%s\n",
+                                           self->addr_width, map->start, self->addr_width, map->end,
+                                           map->flags & XCD_BIN_MAP_FLAG_READ ? 'r' : '-',
+                                           map->flags & XCD_BIN_MAP_FLAG_WRITE ? 'w' : '-',
+                                           map->flags & XCD_BIN_MAP_FLAG_EXEC ? 'x' : '-',
+                                           width_offset, map->offset,
+                                           width_size, size,
+                                           ((map->flags & XCD_BIN_MAP_FLAG_SAME_NAME) && 0 == map->load_bias) ? 1 : map->name_len,
+                                           ((map->flags & XCD_BIN_MAP_FLAG_SAME_NAME) && 0 == map->load_bias) ? ">" : map->name,
+                                           load_bias_buf))) return r;
+    }
+    return xcc_util_write_format(self->out_fd, "    TOTAL SIZE: 0x%"PRIx64"K (%"PRIu64"K)\n\n", total_size / 1024, total_size / 1024);
+}
+
+static int xcd_bin_decoder_end_thread(xcd_bin_decoder_t *self)
+{
+    int r;
+
+    if(self->in_backtrace)
+        if(0 != (r = xcc_util_write_str(self->out_fd, "\n"))) return r;
+    if(self->in_build_id)
+        if(0 != (r = xcc_util_write_str(self->out_fd, "\n"))) return r;
+    if(self->in_crashed_thread && self->maps_num > 0)
+        if(0 != (r = xcd_bin_decoder_render_maps(self))) return r;
+
+    self->in_thread = 0;
+    self->in_crashed_thread = 0;
+    self->in_backtrace = 0;
+    self->in_build_id = 0;
+    return 0;
+}
+
+static int xcd_bin_decoder_render_frame(xcd_bin_decoder_t *self, xcd_bin_reader_t *payload)
+{
+    uint64_t       num, rel_pc, func_offset;
+    xcd_bin_map_t *map;
+    const char    *func_name, *so_name;
+    int            func_name_len, so_name_len;
+    char           name_buf[1100], offset_buf[64], func_buf[1100];
+    int            r;
+
+    if(!self->in_backtrace)
+    {
+        if(0 != (r = xcc_util_write_str(self->out_fd, "backtrace:\n"))) return r;
+        self->in_backtrace = 1;
+    }
+
+    num         = xcd_bin_get_uleb128(payload);
+    (void)xcd_bin_get_uleb128(payload); //absolute pc
+    rel_pc      = xcd_bin_get_uleb128(payload);
+    map         = xcd_bin_decoder_get_map(self, xcd_bin_get_uleb128(payload));
+    func_offset = xcd_bin_get_uleb128(payload);
+    func_name   = xcd_bin_get_bytes(payload, &func_name_len);
+    so_name     = xcd_bin_get_bytes(payload, &so_name_len);
+
+    //name
+    if(NULL == map)
+        snprintf(name_buf, sizeof(name_buf), "<unknown>");
+    else if(0 == map->name_len)
+        snprintf(name_buf, sizeof(name_buf), "<anonymous:%0*"PRIx64">", self->addr_width, map->start);
+    else if(0 != map->elf_start_offset && so_name_len > 0)
+        snprintf(name_buf, sizeof(name_buf), "%.*s!%.*s", map->name_len, map->name, so_name_len, so_name);
+    else
+        snprintf(name_buf, sizeof(name_buf), "%.*s", map->name_len, map->name);
+
+    //offset
+    if(NULL != map && 0 != map->elf_start_offset)
+        snprintf(offset_buf, sizeof(offset_buf), " (offset 0x%"PRIx64")", map->elf_start_offset);
+    else
+        offset_buf[0] = '\0';
+
+    //func
+    if(func_name_len > 0)
+    {
+        if(func_offset > 0)
+            snprintf(func_buf, sizeof(func_buf), " (%.*s+%"PRIu64")", func_name_len, func_name, func_offset);
+        else
+            snprintf(func_buf, sizeof(func_buf), " (%.*s)", func_name_len, func_name);
+    }
+    else
+    {
+        func_buf[0] = '\0';
+    }
+
+    return xcc_util_write_format(self->out_fd, "    #%02"PRIu64" pc %0*"PRIx64"  %s%s%s\n",
+                                 num, self->addr_width, rel_pc, name_buf, offset_buf, func_buf);
+}
+
+static int xcd_bin_decoder_render_build_id(xcd_bin_decoder_t *self, xcd_bin_reader_t *payload)
+{
+    xcd_bin_map_t *map;
+    const char    *build_id, *detail;
+    int            build_id_len, detail_len, i;
+    char           build_id_buf[XCD_BIN_STR_MAX * 2 + 1] = "unknown";
+    int            r;
+
+    if(self->in_backtrace)
+    {
+        if(0 != (r = xcc_util_write_str(self->out_fd, "\n"))) return r;
+        self->in_backtrace = 0;
+    }
+    if(!self->in_build_id)
+    {
+        if(0 != (r = xcc_util_write_str(self->out_fd, "build id:\n"))) return r;
+        self->in_build_id = 1;
+    }
+
+    map      = xcd_bin_decoder_get_map(self, xcd_bin_get_uleb128(payload));
+    build_id = xcd_bin_get_bytes(payload, &build_id_len);
+    detail   = xcd_bin_get_bytes(payload, &detail_len);
+    if(NULL == map) return 0;
+
+    for(i = 0; i < build_id_len; i++)
+        snprintf(build_id_buf + i * 2, 3, "%02hhx", (uint8_t)build_id[i]);
+
+    return xcc_util_write_format(self->out_fd, "    %.*s (BuildId: %s%.*s\n",
+                                 map->name_len, map->name, build_id_buf, detail_len, detail);
+}
+
+int xcd_bin_decode(int in_fd, int out_fd)
+{
+    xcd_bin_decoder_t  self;
+    xcd_bin_reader_t   reader, payload;
+    struct stat        st;
+    uint8_t           *data = MAP_FAILED;
+    size_t             data_len = 0;
+    uint64_t           type, payload_len, pid, tid, crashed;
+    const char        *key, *value, *tname, *pname;
+    int                key_len, value_len, tname_len, pname_len;
+    int                header = 0, completed = 0;
+    int                r = 0;
+
+    memset(&self, 0, sizeof(self));
+    self.out_fd = out_fd;
+
+    //map the whole file
+    if(0 != fstat(in_fd, &st)) return XCC_ERRNO_SYS;
+    if(st.st_size < 6) return XCC_ERRNO_FORMAT;
+    data_len = (size_t)st.st_size;
+    if(MAP_FAILED == (data = (uint8_t *)mmap(NULL, data_len, PROT_READ, MAP_PRIVATE, in_fd, 0))) return XCC_ERRNO_SYS;
+
+    //check file header
+    if(0 != memcmp(data, XCD_BIN_MAGIC, 4) || XCD_BIN_VERSION != data[4] || (4 != data[5] && 8 != data[5]))
+    {
+        r = XCC_ERRNO_FORMAT;
+        goto end;
+    }
+    self.addr_width = data[5] * 2;
+
+    //the map table and the load biases are needed by the frames and the memory map
+    if(0 != (r = xcd_bin_decoder_load_maps(&self, data + 6, data_len - 6))) goto end;
+
+    reader.cur = data + 6;
+    reader.end = data + data_len;
+    reader.error = 0;
+    while(reader.cur < reader.end)
+    {
+        type = xcd_bin_get_uleb128(&reader);
+        payload_len = xcd_bin_get_uleb128(&reader);
+        if(reader.error || payload_len > (uint64_t)(reader.end - reader.cur)) break; //truncated
+        payload.cur = reader.cur;
+        payload.end = reader.cur + payload_len;
+        payload.error = 0;
+        reader.cur += payload_len;
+
+        switch(type)
+        {
+        case XCD_BIN_REC_HEADER_ITEM:
+            if(!header)
+            {
+                if(0 != (r = xcc_util_write_str(out_fd, XCC_UTIL_TOMB_HEAD))) goto end;
+                header = 1;
+            }
+            key = xcd_bin_get_bytes(&payload, &key_len);
+            value = xcd_bin_get_bytes(&payload, &value_len);
+            if(0 != (r = xcc_util_write_format(out_fd, "%.*s: '%.*s'\n", key_len, key, value_len, value))) goto end;
+            break;
+        case XCD_BIN_REC_THREAD:
+            if(0 != (r = xcd_bin_decoder_end_thread(&self))) goto end;
+            pid = xcd_bin_get_uleb128(&payload);
+            tid = xcd_bin_get_uleb128(&payload);
+            crashed = xcd_bin_get_uleb128(&payload);
+            tname = xcd_bin_get_bytes(&payload, &tname_len);
+            pname = xcd_bin_get_bytes(&payload, &pname_len);
+            if(!crashed)
+            {
+                if(0 != (r = xcc_util_write_str(out_fd, XCC_UTIL_THREAD_SEP))) goto end;
+                self.other_threads++;
+            }
+            if(0 != (r = xcc_util_write_format(out_fd, "pid: %"PRIu64", tid: %"PRIu64", name: %.*s  >>> %.*s <<<\n",
+                                               pid, tid, tname_len, tname, pname_len, pname))) goto end;
+            self.in_thread = 1;
+            self.in_crashed_thread = (crashed ? 1 : 0);
+            break;
+        case XCD_BIN_REC_FRAME:
+            if(self.in_thread)
+                if(0 != (r = xcd_bin_decoder_render_frame(&self, &payload))) goto end;
+            break;
+        case XCD_BIN_REC_BUILD_ID:
+            if(self.in_thread)
+                if(0 != (r = xcd_bin_decoder_render_build_id(&self, &payload))) goto end;
+            break;
+        case XCD_BIN_REC_END:
+            completed = 1;
+            break;
+        default:
+            break; //unknown record from a newer version, skip it
+        }
+    }
+    if(0 != (r = xcd_bin_decoder_end_thread(&self))) goto end;
+
+    if(self.other_threads > 0)
+    {
+        if(0 != (r = xcc_util_write_str(out_fd, XCC_UTIL_THREAD_SEP))) goto end;
+        if(0 != (r = xcc_util_write_format(out_fd, "dumped threads: %zu\n", self.other_threads))) goto end;
+        if(0 != (r = xcc_util_write_str(out_fd, XCC_UTIL_THREAD_END))) goto end;
+    }
+    if(!completed)
+        r = xcc_util_write_str(out_fd, "\n\nxcrash error debug:\nbinary tombstone is incomplete\n\n");
+
+ end:
+    if(NULL != self.maps) xcd_arena_heap_free(self.maps);
+    if(MAP_FAILED != data) munmap(data, data_len);
+    return r;
+}
+
+#pragma clang diagnostic pop
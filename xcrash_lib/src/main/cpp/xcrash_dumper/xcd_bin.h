@@ -0,0 +1,86 @@
+// Copyright (c) 2020-present, HexHacking Team. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+
+#ifndef XCD_BIN_H
+#define XCD_BIN_H 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//binary tombstone
+//
+//file header: magic (4 bytes) + version (1 byte) + address size in bytes (1 byte)
+//record:      type (ULEB128) + payload length (ULEB128) + payload
+//payload:     integers are ULEB128, strings and bytes are length (ULEB128) + data (not NUL-terminated)
+//
+//MAP records make up the map table, a map is referenced by its index in the table plus 1 (0 means no map).
+//The map table is written before the threads, so an incomplete file still has the names of the maps,
+//the load biases are only known after the ELFs are loaded, they are written later in LOAD_BIAS records.
+//FRAME and BUILD_ID records belong to the THREAD record before them.
+//Only the crashed thread has BUILD_ID records, unless the symbolization is deferred.
+//The END record is written only when the dumping is completed.
+#define XCD_BIN_MAGIC                "XCBT"
+#define XCD_BIN_VERSION              1
+#define XCD_BIN_SUFFIX               ".xcbin"
+
+#define XCD_BIN_REC_HEADER_ITEM      1 //key, value
+#define XCD_BIN_REC_MAP              2 //start, end, offset, flags, elf_start_offset, load_bias (always 0), name
+#define XCD_BIN_REC_THREAD           3 //pid, tid, crashed, tname, pname
+#define XCD_BIN_REC_FRAME            4 //num, pc, rel_pc, map, func_offset, func_name, so_name (embedded ELF)
+#define XCD_BIN_REC_BUILD_ID         5 //map, build-id (bytes), detail (file size, last modified, MD5 or error)
+#define XCD_BIN_REC_END              6 //(empty)
+#define XCD_BIN_REC_LOAD_BIAS        7 //map, load_bias
+
+#define XCD_BIN_MAP_FLAG_READ        0x1
+#define XCD_BIN_MAP_FLAG_WRITE       0x2
+#define XCD_BIN_MAP_FLAG_EXEC        0x4
+#define XCD_BIN_MAP_FLAG_SAME_NAME   0x8 //same name as the previous map, the name is not saved
+
+int xcd_bin_open(const char *log_pathname);
+int xcd_bin_is_opened(void);
+void xcd_bin_flush(void);
+void xcd_bin_close(void);
+
+//records are buffered, and are ignored if the binary tombstone is not opened
+void xcd_bin_record_header(const char *header);
+void xcd_bin_record_map(uintptr_t start, uintptr_t end, size_t offset, unsigned int flags,
+                        size_t elf_start_offset, uintptr_t load_bias, const char *name);
+void xcd_bin_record_load_bias(size_t map, uintptr_t load_bias);
+void xcd_bin_record_thread(pid_t pid, pid_t tid, int crashed, const char *tname, const char *pname);
+void xcd_bin_record_frame(size_t num, uintptr_t pc, uintptr_t rel_pc, size_t map,
+                          size_t func_offset, const char *func_name, const char *so_name);
+void xcd_bin_record_build_id(size_t map, const uint8_t *build_id, size_t build_id_len, const char *detail);
+
+//render the binary tombstone in the text layout
+int xcd_bin_decode(int in_fd, int out_fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
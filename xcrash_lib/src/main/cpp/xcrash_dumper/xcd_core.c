@@ -36,6 +36,7 @@
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
 #include <sys/ptrace.h>
 #include <sys/wait.h>
 #include <linux/elf.h>
@@ -47,13 +48,18 @@
 #include "xcc_util.h"
 #include "xcc_spot.h"
 #include "xcd_log.h"
+#include "xcd_arena.h"
+#include "xcd_bin.h"
 #include "xcd_process.h"
+#include "xcd_symbolizer.h"
 #include "xcd_sys.h"
 #include "xcd_util.h"
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wgnu-statement-expression"
 
+#define XCD_CORE_WRITER_BUF_SIZE (64 * 1024)
+
 static int                    xcd_core_handled      = 0;
 static int                    xcd_core_log_fd       = -1;
 static xcd_process_t         *xcd_core_proc         = NULL;
@@ -86,19 +92,56 @@ static int xcd_core_read_stdin(void *buf, size_t len)
     return 0;
 }
 
+//in standby mode, the log fd arrives along with the first bytes of the args (SCM_RIGHTS)
+static int xcd_core_recv_stdin_with_fd(void *buf, size_t len, int *fd)
+{
+    struct msghdr   msg;
+    struct iovec    iov = {.iov_base = buf, .iov_len = len};
+    union
+    {
+        struct cmsghdr hdr;
+        char           buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct cmsghdr *cmsg;
+    ssize_t         n;
+
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    n = XCC_UTIL_TEMP_FAILURE_RETRY(recvmsg(STDIN_FILENO, &msg, MSG_CMSG_CLOEXEC));
+    if(n <= 0) return XCC_ERRNO_SYS;
+
+    *fd = -1;
+    if(NULL != (cmsg = CMSG_FIRSTHDR(&msg)) && SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type)
+        memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
+
+    if((size_t)n < len) return xcd_core_read_stdin((void *)((uint8_t *)buf + n), len - (size_t)n);
+    return 0;
+}
+
 static int xcd_core_read_stdin_extra(char **buf, size_t len)
 {
     if(0 == len) return XCC_ERRNO_INVAL;
-    if(NULL == ((*buf) = (char *)calloc(1, len + 1))) return XCC_ERRNO_NOMEM;
+    if(NULL == ((*buf) = (char *)xcd_arena_calloc(1, len + 1))) return XCC_ERRNO_NOMEM;
     return xcd_core_read_stdin((void *)(*buf), len);
 }
 
-static int xcd_core_read_args()
+static int xcd_core_read_args(int standby)
 {
-    int r;
+    int r, fd;
     
-    if(0 != (r = xcd_core_read_stdin((void *)&xcd_core_spot, sizeof(xcc_spot_t)))) return r;
-    if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_log_pathname, xcd_core_spot.log_pathname_len))) return r;
+    if(standby)
+    {
+        if(0 != (r = xcd_core_recv_stdin_with_fd((void *)&xcd_core_spot, sizeof(xcc_spot_t), &fd))) return r;
+        xcd_core_spot.log_fd = fd;
+    }
+    else
+    {
+        if(0 != (r = xcd_core_read_stdin((void *)&xcd_core_spot, sizeof(xcc_spot_t)))) return r;
+    }
     if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_os_version, xcd_core_spot.os_version_len))) return r;
     if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_kernel_version, xcd_core_spot.kernel_version_len))) return r;
     if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_abi_list, xcd_core_spot.abi_list_len))) return r;
@@ -110,6 +153,9 @@ static int xcd_core_read_args()
     if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_app_version, xcd_core_spot.app_version_len))) return r;
     if(xcd_core_spot.dump_all_threads_allowlist_len > 0)
         if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_dump_all_threads_allowlist, xcd_core_spot.dump_all_threads_allowlist_len))) return r;
+
+    //set when crashed, after the strings serialized when inited
+    if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_log_pathname, xcd_core_spot.log_pathname_len))) return r;
     
     return 0;
 }
@@ -125,6 +171,10 @@ static void xcd_core_signal_handler(int sig, siginfo_t *si, void *uc)
     if(xcd_core_handled) _exit(200);
     xcd_core_handled = 1;
 
+    //save the buffered logs, and write the following ones directly
+    xcc_util_writer_uninit();
+    xcd_bin_flush();
+
     //restore the signal handler
     if(0 != xcc_signal_crash_unregister()) _exit(10);
 
@@ -138,6 +188,7 @@ static void xcd_core_signal_handler(int sig, siginfo_t *si, void *uc)
                                            si->si_signo, si->si_code)) goto end;
         if(0 < (len = xcc_unwind_get(xcd_core_spot.api_level, si, uc, buf, sizeof(buf))))
             xcc_util_write(xcd_core_log_fd, buf, len);
+        xcd_arena_record(xcd_core_log_fd);
 
     end:
         xcc_util_write_str(xcd_core_log_fd, "\n\n");
@@ -146,39 +197,103 @@ static void xcd_core_signal_handler(int sig, siginfo_t *si, void *uc)
     xcc_signal_crash_queue(si);
 }
 
+static void xcd_core_alarm_handler(int sig)
+{
+    //save the buffered logs, then be killed by the timeout as before
+    xcc_util_writer_uninit();
+    xcd_bin_flush();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void xcd_core_exit_handler(void)
+{
+    xcc_util_writer_uninit();
+    xcd_bin_flush();
+}
+
+//render a binary tombstone in the text layout: libxcrash_dumper.so --decode <tombstone.xcbin>
+static int xcd_core_decode(const char *pathname)
+{
+    int fd, r;
+
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, O_RDONLY | O_CLOEXEC)))) return 1;
+    r = xcd_bin_decode(fd, STDOUT_FILENO);
+    close(fd);
+    return 0 == r ? 0 : 2;
+}
+
+//render a raw tombstone (deferred symbolization): libxcrash_dumper.so --symbolize <raw.xcrash> <tombstone.xcrash> [--elf-hash]
+static int xcd_core_symbolize(int argc, char** argv)
+{
+    int dump_elf_hash = (5 == argc && 0 == strcmp(argv[4], "--elf-hash"));
+
+    return 0 == xcd_symbolizer_render(argv[2], argv[3], dump_elf_hash) ? 0 : 2;
+}
+
 int main(int argc, char** argv)
 {
-    (void)argc;
-    (void)argv;
+    if(3 == argc && 0 == strcmp(argv[1], "--decode")) return xcd_core_decode(argv[2]);
+    if((4 == argc || 5 == argc) && 0 == strcmp(argv[1], "--symbolize")) return xcd_core_symbolize(argc, argv);
+
+    //standby mode: spawned when xCrash is initialized, the args arrive when the process crashed
+    int standby = (2 == argc && 0 == strcmp(argv[1], XCC_UTIL_XCRASH_DUMPER_STANDBY));
     
     //don't leave a zombie process
-    alarm(30);
+    if(!standby) alarm(30);
 
     //read args from stdin
-    if(0 != xcd_core_read_args()) exit(1);
+    //(in standby mode, it's EOF if the process exits without crashing)
+    if(0 != xcd_core_read_args(standby)) exit(1);
+    if(standby) alarm(30);
 
-    //open log file
-    if(0 > (xcd_core_log_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xcd_core_log_pathname, O_WRONLY | O_CLOEXEC)))) exit(2);
+    //the log file opened by the crashed process, we share the file offset with it
+    if(0 > (xcd_core_log_fd = xcd_core_spot.log_fd) || 0 > fcntl(xcd_core_log_fd, F_GETFL)) exit(2);
+
+    //open binary tombstone
+    if(xcd_core_spot.dump_binary) xcd_bin_open(xcd_core_log_pathname);
+
+    //buffer the logs, flush them at section boundaries, before exit and on timeout
+    if(0 == xcc_util_writer_init(xcd_core_log_fd, XCD_CORE_WRITER_BUF_SIZE))
+    {
+        atexit(xcd_core_exit_handler);
+        signal(SIGALRM, xcd_core_alarm_handler);
+    }
 
     //register signal handler for catching self-crashing
     xcc_unwind_init(xcd_core_spot.api_level);
     xcc_signal_crash_register(xcd_core_signal_handler);
 
     //create process object
+    //(for live snapshot, there is no signal, the regs of the requesting thread are loaded by ptrace)
     if(0 != xcd_process_create(&xcd_core_proc,
                                xcd_core_spot.crash_pid,
                                xcd_core_spot.crash_tid,
-                               &(xcd_core_spot.siginfo),
-                               &(xcd_core_spot.ucontext))) exit(3);
+                               xcd_core_spot.snapshot ? NULL : &(xcd_core_spot.siginfo),
+                               xcd_core_spot.snapshot ? NULL : &(xcd_core_spot.ucontext))) exit(3);
 
     //suspend all threads in the process
     xcd_process_suspend_threads(xcd_core_proc);
 
     //load process info
     if(0 != xcd_process_load_info(xcd_core_proc)) exit(4);
+    xcd_process_record_bin_maps(xcd_core_proc);
+
+    //for live snapshot, unwind the selected threads while they are still stopped,
+    //then resume all threads before symbolizing and formatting,
+    //from now on, only the stack snapshots and the read-only mappings are read from the remote process
+    if(xcd_core_spot.snapshot)
+    {
+        xcd_process_load_snapshot_frames(xcd_core_proc,
+                                         xcd_core_spot.dump_all_threads_count_max,
+                                         xcd_core_dump_all_threads_allowlist);
+        xcd_process_resume_threads(xcd_core_proc);
+        xcd_process_set_snapshots_only(xcd_core_proc);
+    }
 
     //record system info
     if(0 != xcd_sys_record(xcd_core_log_fd,
+                           xcd_core_spot.snapshot ? XCC_UTIL_CRASH_TYPE_NATIVE_SNAPSHOT : XCC_UTIL_CRASH_TYPE_NATIVE,
                            xcd_core_spot.time_zone,
                            xcd_core_spot.start_time,
                            xcd_core_spot.crash_time,
@@ -194,25 +309,48 @@ int main(int argc, char** argv)
                            xcd_core_build_fingerprint)) exit(5);
 
     //record process info
-    if(0 != xcd_process_record(xcd_core_proc,
-                               xcd_core_log_fd,
-                               xcd_core_spot.logcat_system_lines,
-                               xcd_core_spot.logcat_events_lines,
-                               xcd_core_spot.logcat_main_lines,
-                               xcd_core_spot.dump_elf_hash,
-                               xcd_core_spot.dump_map,
-                               xcd_core_spot.dump_fds,
-                               xcd_core_spot.dump_network_info,
-                               xcd_core_spot.dump_all_threads,
-                               xcd_core_spot.dump_all_threads_count_max,
-                               xcd_core_dump_all_threads_allowlist,
-                               xcd_core_spot.api_level)) exit(6);
+    if(xcd_core_spot.snapshot)
+    {
+        if(0 != xcd_process_record_snapshot(xcd_core_proc,
+                                            xcd_core_log_fd,
+                                            xcd_core_spot.dump_all_threads_count_max)) exit(6);
+    }
+    else
+    {
+        if(0 != xcd_process_record(xcd_core_proc,
+                                   xcd_core_log_fd,
+                                   xcd_core_spot.logcat_system_lines,
+                                   xcd_core_spot.logcat_events_lines,
+                                   xcd_core_spot.logcat_main_lines,
+                                   xcd_core_spot.dump_elf_hash,
+                                   xcd_core_spot.defer_symbols,
+                                   xcd_core_spot.dump_map,
+                                   xcd_core_spot.dump_fds,
+                                   xcd_core_spot.dump_network_info,
+                                   xcd_core_spot.dump_all_threads,
+                                   xcd_core_spot.dump_all_threads_count_max,
+                                   xcd_core_dump_all_threads_allowlist,
+                                   xcd_core_spot.api_level)) exit(6);
+    }
+    xcd_process_record_bin_load_bias(xcd_core_proc);
+    xcd_bin_close();
+
+    //some allocations failed, the dumper's memory usage hit the cap
+    //(otherwise, the usage is recorded at the end of the other threads)
+    if(xcd_arena_is_full())
+    {
+        if(0 == xcc_util_write_str(xcd_core_log_fd, "\n\nxcrash error debug:\n"))
+            if(0 == xcd_arena_record(xcd_core_log_fd))
+                xcc_util_write_str(xcd_core_log_fd, "\n\n");
+    }
 
     //resume all threads in the process
-    xcd_process_resume_threads(xcd_core_proc);
+    if(!xcd_core_spot.snapshot) xcd_process_resume_threads(xcd_core_proc);
 
 #if XCD_CORE_DEBUG
-    XCD_LOG_DEBUG("CORE: done");
+    size_t arena_used, arena_mapped, arena_heap_peak;
+    xcd_arena_get_stats(&arena_used, &arena_mapped, NULL, &arena_heap_peak, NULL, NULL);
+    XCD_LOG_DEBUG("CORE: done, arena used=%zu, mapped=%zu, heap peak=%zu", arena_used, arena_mapped, arena_heap_peak);
 #endif
     return 0;
 }
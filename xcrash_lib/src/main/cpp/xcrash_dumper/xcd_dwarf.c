@@ -40,6 +40,7 @@
 #include "xcd_regs.h"
 #include "xcd_log.h"
 #include "xcd_util.h"
+#include "xcd_arena.h"
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
@@ -91,42 +92,40 @@ RB_GENERATE_STATIC(xcd_dwarf_cie_tree, xcd_dwarf_cie, link, xcd_dwarf_cie_cmp)
 #pragma clang diagnostic pop
 
 //FDE
-typedef struct
+typedef struct xcd_dwarf_fde
 {
     uint64_t  cfa_instructions_offset;
     uint64_t  cfa_instructions_end;
     uintptr_t pc_start;
     uintptr_t pc_end;
     xcd_dwarf_cie_t *cie;
+    int       cached; //saved in the cache and kept, otherwise it's freed after the step
+    RB_ENTRY(xcd_dwarf_fde) link;
 } xcd_dwarf_fde_t;
-
-//DWARF object
-struct xcd_dwarf
+static int xcd_dwarf_fde_cmp(xcd_dwarf_fde_t *a, xcd_dwarf_fde_t *b)
 {
-    xcd_dwarf_type_t          type;
-    pid_t                     pid;
-    uintptr_t                 load_bias;
-    uintptr_t                 hdr_load_bias; //for .eh_frame_hdr
-    xcd_dwarf_cie_tree_t      cie_cache;
-    
-    xcd_memory_t             *memory;
-    size_t                    memory_cur_offset;
-    size_t                    memory_pc_offset;
-    size_t                    memory_data_offset;
-    
-    size_t                    pc_offset;
+    //overlapping PC ranges are treated as equal
+    if(a->pc_end <= b->pc_start) return -1;
+    else if(a->pc_start >= b->pc_end) return 1;
+    else return 0;
+}
+typedef RB_HEAD(xcd_dwarf_fde_tree, xcd_dwarf_fde) xcd_dwarf_fde_tree_t;
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+RB_GENERATE_STATIC(xcd_dwarf_fde_tree, xcd_dwarf_fde, link, xcd_dwarf_fde_cmp)
+#pragma clang diagnostic pop
 
-    //XCD_DWARF_TYPE_DEBUG_FRAME  mode: starting / ending offset of .debug_frame
-    //XCD_DWARF_TYPE_EH_FRAME     mode: starting / ending offset of .eh_frame
-    //XCD_DWARF_TYPE_EH_FRAME_HDR mode: starting / ending offset of binary search table in .eh_frame_hdr
-    size_t                    entries_offset;
-    size_t                    entries_end;
+//max number of FDEs cached in each DWARF object
+#define XCD_DWARF_FDE_CACHE_MAX 1024
 
-    //for XCD_DWARF_TYPE_EH_FRAME_HDR mode only
-    size_t                    eh_frame_hdr_fde_count;
-    uint8_t                   eh_frame_hdr_table_encoding;
-    size_t                    eh_frame_hdr_table_entry_size;
-};
+//sorted FDE index (for .eh_frame without .eh_frame_hdr and .debug_frame)
+typedef struct
+{
+    uintptr_t pc_start;
+    uintptr_t pc_end;
+    size_t    offset;
+    uintptr_t max_end; //the largest pc_end of this and all the previous FDEs
+} xcd_dwarf_fde_index_t;
 
 //location rule type
 #define DW_LOC_INVALID        0
@@ -160,6 +159,81 @@ typedef struct xcd_dwarf_loc_node
 } xcd_dwarf_loc_node_t;
 typedef TAILQ_HEAD(xcd_dwarf_loc_node_stack, xcd_dwarf_loc_node,) xcd_dwarf_loc_node_stack_t;
 
+//location cache (only the rules used by eval are saved)
+typedef struct xcd_dwarf_loc_cache
+{
+    uint64_t             fde_instructions_offset; //key
+    uintptr_t            pc; //key
+    xcd_dwarf_loc_rule_t cfa_rule;
+    xcd_dwarf_loc_rule_t reg_rules[XCD_REGS_MACHINE_NUM];
+    RB_ENTRY(xcd_dwarf_loc_cache) link;
+} xcd_dwarf_loc_cache_t;
+static int xcd_dwarf_loc_cache_cmp(xcd_dwarf_loc_cache_t *a, xcd_dwarf_loc_cache_t *b)
+{
+    if(a->fde_instructions_offset != b->fde_instructions_offset)
+        return (a->fde_instructions_offset > b->fde_instructions_offset ? 1 : -1);
+    if(a->pc != b->pc)
+        return (a->pc > b->pc ? 1 : -1);
+    return 0;
+}
+typedef RB_HEAD(xcd_dwarf_loc_tree, xcd_dwarf_loc_cache) xcd_dwarf_loc_tree_t;
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+RB_GENERATE_STATIC(xcd_dwarf_loc_tree, xcd_dwarf_loc_cache, link, xcd_dwarf_loc_cache_cmp)
+#pragma clang diagnostic pop
+
+//max number of locations cached in each DWARF object
+#define XCD_DWARF_LOC_CACHE_MAX 256
+
+//size of the local read window (used when the memory can not be accessed directly)
+#define XCD_DWARF_WINDOW_BUF_SIZE 256
+
+//DWARF object
+struct xcd_dwarf
+{
+    xcd_dwarf_type_t          type;
+    pid_t                     pid;
+    uintptr_t                 load_bias;
+    uintptr_t                 hdr_load_bias; //for .eh_frame_hdr
+    xcd_dwarf_cie_tree_t      cie_cache;
+    xcd_dwarf_fde_tree_t      fde_cache;
+    size_t                    fde_cache_count;
+    
+    xcd_memory_t             *memory;
+    size_t                    memory_cur_offset;
+    size_t                    memory_pc_offset;
+    size_t                    memory_data_offset;
+
+    //read window: data of [window_offset, window_offset + window_size) in the memory
+    const uint8_t            *window;
+    size_t                    window_offset;
+    size_t                    window_size;
+    uint8_t                   window_buf[XCD_DWARF_WINDOW_BUF_SIZE];
+    
+    size_t                    pc_offset;
+
+    //XCD_DWARF_TYPE_DEBUG_FRAME  mode: starting / ending offset of .debug_frame
+    //XCD_DWARF_TYPE_EH_FRAME     mode: starting / ending offset of .eh_frame
+    //XCD_DWARF_TYPE_EH_FRAME_HDR mode: starting / ending offset of binary search table in .eh_frame_hdr
+    size_t                    entries_offset;
+    size_t                    entries_end;
+
+    //for XCD_DWARF_TYPE_EH_FRAME_HDR mode only
+    size_t                    eh_frame_hdr_fde_count;
+    uint8_t                   eh_frame_hdr_table_encoding;
+    size_t                    eh_frame_hdr_table_entry_size;
+    const int32_t            *eh_frame_hdr_table; //for DW_EH_PE_datarel|DW_EH_PE_sdata4 only
+
+    //for XCD_DWARF_TYPE_EH_FRAME and XCD_DWARF_TYPE_DEBUG_FRAME mode only (loaded on first use)
+    xcd_dwarf_fde_index_t    *fde_index;
+    size_t                    fde_index_count;
+    int                       fde_index_loaded;
+
+    //cache of locations
+    xcd_dwarf_loc_tree_t      loc_cache;
+    size_t                    loc_cache_count;
+};
+
 //cfa
 typedef struct
 {
@@ -535,9 +609,49 @@ static uintptr_t xcd_dwarf_adjust_pc_from_fde(xcd_dwarf_t *self, size_t cur_fiel
         return (uintptr_t)cur_field_offset + v;
 }
 
+//make sure the read window contains the data at memory_cur_offset, return the number of bytes available
+static size_t xcd_dwarf_fill_window(xcd_dwarf_t *self)
+{
+    const void *ptr = NULL;
+    size_t      size;
+
+    //hit the current window
+    if(NULL != self->window && self->memory_cur_offset >= self->window_offset &&
+       self->memory_cur_offset - self->window_offset < self->window_size)
+        return self->window_size - (self->memory_cur_offset - self->window_offset);
+
+    //zero-copy for the local memory
+    if(0 < (size = xcd_memory_peek(self->memory, self->memory_cur_offset, &ptr)))
+    {
+        self->window = (const uint8_t *)ptr;
+    }
+    else
+    {
+        //copy to the local buffer
+        if(0 == (size = xcd_memory_read(self->memory, self->memory_cur_offset, self->window_buf, sizeof(self->window_buf))))
+        {
+            self->window = NULL;
+            return 0;
+        }
+        self->window = self->window_buf;
+    }
+    self->window_offset = self->memory_cur_offset;
+    self->window_size = size;
+
+    return size;
+}
+
 static int xcd_dwarf_read_bytes(xcd_dwarf_t *self, void *value, size_t size)
 {
     int r;
+
+    //read from the window
+    if(xcd_dwarf_fill_window(self) >= size)
+    {
+        memcpy(value, self->window + (self->memory_cur_offset - self->window_offset), size);
+        self->memory_cur_offset += size;
+        return 0;
+    }
     
     if(0 != (r = xcd_memory_read_fully(self->memory, self->memory_cur_offset, value, size))) return r;
     self->memory_cur_offset += size;
@@ -545,25 +659,52 @@ static int xcd_dwarf_read_bytes(xcd_dwarf_t *self, void *value, size_t size)
     return 0;
 }
 
+static int xcd_dwarf_read_u8(xcd_dwarf_t *self, uint8_t *value)
+{
+    if(0 == xcd_dwarf_fill_window(self)) return XCC_ERRNO_MISSING;
+
+    *value = self->window[self->memory_cur_offset - self->window_offset];
+    self->memory_cur_offset += 1;
+
+    return 0;
+}
+
 static int xcd_dwarf_read_uleb128(xcd_dwarf_t *self, uint64_t *value)
 {
-    size_t i;
-    int    r;
-    
-    if(0 != (r = xcd_memory_read_uleb128(self->memory, self->memory_cur_offset, value, &i))) return r;
-    self->memory_cur_offset += i;
-    
+    uint64_t cur_value = 0;
+    uint64_t shift = 0;
+    uint8_t  byte;
+    int      r;
+
+    do
+    {
+        if(0 != (r = xcd_dwarf_read_u8(self, &byte))) return r;
+        if(shift < 64) cur_value += ((uint64_t)(byte & 0x7f) << shift);
+        shift += 7;
+    }while(byte & 0x80);
+
+    *value = cur_value;
     return 0;
 }
 
 static int xcd_dwarf_read_sleb128(xcd_dwarf_t *self, int64_t *value)
 {
-    size_t i;
-    int    r;
+    uint64_t cur_value = 0;
+    uint64_t shift = 0;
+    uint8_t  byte;
+    int      r;
 
-    if(0 != (r = xcd_memory_read_sleb128(self->memory, self->memory_cur_offset, value, &i))) return r;
-    self->memory_cur_offset += i;
-    
+    do
+    {
+        if(0 != (r = xcd_dwarf_read_u8(self, &byte))) return r;
+        if(shift < 64) cur_value += ((uint64_t)(byte & 0x7f) << shift);
+        shift += 7;
+    }while(byte & 0x80);
+
+    if((byte & 0x40) && shift < 64)
+        cur_value |= ((uint64_t)(-1) << shift);
+
+    *value = (int64_t)cur_value;
     return 0;
 }
 
@@ -686,7 +827,7 @@ static xcd_dwarf_cie_t *xcd_dwarf_get_cie_from_offset(xcd_dwarf_t *self, size_t
     if(NULL != (cie = RB_FIND(xcd_dwarf_cie_tree, &(self->cie_cache), &cie_key))) return cie;
     
     //create cie
-    if(NULL == (cie = calloc(1, sizeof(xcd_dwarf_cie_t)))) goto err;
+    if(NULL == (cie = xcd_arena_calloc(1, sizeof(xcd_dwarf_cie_t)))) goto err;
     cie->offset = offset; //key
     
     //get length
@@ -798,42 +939,40 @@ static xcd_dwarf_cie_t *xcd_dwarf_get_cie_from_offset(xcd_dwarf_t *self, size_t
 #if XCD_DWARF_DEBUG
     XCD_LOG_DEBUG("DWARF: get CIE failed, offset=%"PRIxPTR, offset);
 #endif
-    if(NULL != cie) free(cie);
     return NULL;
 }
 
 //////////////////////////////////////////////////////////////////////
 // get FDE
 
-static xcd_dwarf_fde_t *xcd_dwarf_get_fde_from_offset(xcd_dwarf_t *self, size_t *offset, uintptr_t pc)
+//parse FDE header, return the CIE and PC range, save the offset of next entry to *next_offset
+static int xcd_dwarf_read_fde_header(xcd_dwarf_t *self, size_t offset, xcd_dwarf_cie_t **cie,
+                                     uintptr_t *pc_start, uintptr_t *pc_end, size_t *next_offset)
 {
-    xcd_dwarf_fde_t *fde = NULL;
-    xcd_dwarf_cie_t *cie;
-    uint64_t         cfa_instructions_offset;
-    uint64_t         cfa_instructions_end = self->entries_end;
-    uintptr_t        pc_start;
-    uintptr_t        pc_end;
-    size_t           cur_offset;
-    size_t           cie_offset;
-    uint32_t         v32;
-    uint64_t         v64;
-    size_t           cur_field_offset;
+    uint64_t cfa_instructions_end = self->entries_end;
+    size_t   cur_offset;
+    size_t   cie_offset;
+    uint32_t v32;
+    uint64_t v64;
+    size_t   cur_field_offset;
+    int      r = XCC_ERRNO_FORMAT;
 
-    self->memory_cur_offset = *offset;
+    self->memory_cur_offset = offset;
 
     //get length
-    if(0 != xcd_dwarf_read_bytes(self, &v32, 4)) goto end;
+    if(0 != (r = xcd_dwarf_read_bytes(self, &v32, 4))) goto end;
     
     if((uint32_t)(-1) == v32) //64bits DWARF FDE
     {
         //get extended length
-        if(0 != xcd_dwarf_read_bytes(self, &v64, 8)) goto end;
+        if(0 != (r = xcd_dwarf_read_bytes(self, &v64, 8))) goto end;
         if(v64 > SIZE_MAX) goto end;
         cfa_instructions_end = self->memory_cur_offset + (size_t)v64;
 
         //get CIE offset
         cur_field_offset = self->memory_cur_offset;
-        if(0 != xcd_dwarf_read_bytes(self, &v64, 8)) goto end;
+        if(0 != (r = xcd_dwarf_read_bytes(self, &v64, 8))) goto end;
+        r = XCC_ERRNO_FORMAT;
         if(xcd_dwarf_is_cie_64(self, v64)) goto end; //ignore cie
         if(v64 > SIZE_MAX) goto end;
         cie_offset = xcd_dwarf_adjust_cie_offset(self, cur_field_offset, (size_t)v64);
@@ -844,32 +983,53 @@ static xcd_dwarf_fde_t *xcd_dwarf_get_fde_from_offset(xcd_dwarf_t *self, size_t
         
         //get CIE offset
         cur_field_offset = self->memory_cur_offset;
-        if(0 != xcd_dwarf_read_bytes(self, &v32, 4)) goto end;
+        if(0 != (r = xcd_dwarf_read_bytes(self, &v32, 4))) goto end;
+        r = XCC_ERRNO_FORMAT;
         if(xcd_dwarf_is_cie_32(self, v32)) goto end; //ignore cie
         cie_offset = xcd_dwarf_adjust_cie_offset(self, cur_field_offset, (size_t)v32);
     }
 
     //get CIE
     cur_offset = self->memory_cur_offset;
-    cie = xcd_dwarf_get_cie_from_offset(self, cie_offset);
+    *cie = xcd_dwarf_get_cie_from_offset(self, cie_offset);
     self->memory_cur_offset = cur_offset;
-    if(NULL == cie) goto end;
+    if(NULL == *cie) goto end;
 
     //skip segment selector
-    self->memory_cur_offset += cie->segment_size;
+    self->memory_cur_offset += (*cie)->segment_size;
 
     //get PC start
     cur_field_offset = self->memory_cur_offset;
     self->memory_pc_offset = self->load_bias;
-    if(0 != xcd_dwarf_read_encoded(self, &v64, cie->fde_address_encoding)) goto end;
-    pc_start = xcd_dwarf_adjust_pc_from_fde(self, cur_field_offset, (uintptr_t)v64);
+    if(0 != (r = xcd_dwarf_read_encoded(self, &v64, (*cie)->fde_address_encoding))) goto end;
+    *pc_start = xcd_dwarf_adjust_pc_from_fde(self, cur_field_offset, (uintptr_t)v64);
 
     //get PC Range
     self->memory_pc_offset = 0; //PC Range is always an absolute value
-    if(0 != xcd_dwarf_read_encoded(self, &v64, cie->fde_address_encoding)) goto end;
+    if(0 != (r = xcd_dwarf_read_encoded(self, &v64, (*cie)->fde_address_encoding))) goto end;
 
     //get PC end
-    pc_end = pc_start + (uintptr_t)v64;
+    *pc_end = *pc_start + (uintptr_t)v64;
+
+    r = 0;
+
+ end:
+    *next_offset = (size_t)cfa_instructions_end; //pointer to next entry
+    return r;
+}
+
+static xcd_dwarf_fde_t *xcd_dwarf_get_fde_from_offset(xcd_dwarf_t *self, size_t *offset, uintptr_t pc)
+{
+    xcd_dwarf_fde_t *fde = NULL;
+    xcd_dwarf_cie_t *cie;
+    uint64_t         cfa_instructions_offset;
+    size_t           cfa_instructions_end;
+    uintptr_t        pc_start;
+    uintptr_t        pc_end;
+    uint64_t         v64;
+
+    //get CIE and PC range
+    if(0 != xcd_dwarf_read_fde_header(self, *offset, &cie, &pc_start, &pc_end, &cfa_instructions_end)) goto end;
 
     //check current PC
     if(pc < pc_start || pc >= pc_end) goto end;
@@ -888,22 +1048,124 @@ static xcd_dwarf_fde_t *xcd_dwarf_get_fde_from_offset(xcd_dwarf_t *self, size_t
     if(cfa_instructions_offset > cfa_instructions_end) goto end;
 
     //build FDE info object
-    if(NULL == (fde = malloc(sizeof(xcd_dwarf_fde_t)))) goto end;
+    if(NULL == (fde = xcd_arena_heap_malloc(sizeof(xcd_dwarf_fde_t)))) goto end;
     fde->cfa_instructions_offset = cfa_instructions_offset;
     fde->cfa_instructions_end = cfa_instructions_end;
     fde->pc_start = pc_start;
     fde->pc_end = pc_end;
     fde->cie = cie;
+    fde->cached = 0;
 
  end:
-    *offset = (size_t)cfa_instructions_end; //pointer to next entry
+    *offset = cfa_instructions_end; //pointer to next entry
     return fde;
 }
 
+static int xcd_dwarf_fde_index_cmp(const void *a, const void *b)
+{
+    const xcd_dwarf_fde_index_t *ia = (const xcd_dwarf_fde_index_t *)a;
+    const xcd_dwarf_fde_index_t *ib = (const xcd_dwarf_fde_index_t *)b;
+
+    if(ia->pc_start != ib->pc_start) return (ia->pc_start > ib->pc_start ? 1 : -1);
+    if(ia->offset != ib->offset) return (ia->offset > ib->offset ? 1 : -1);
+    return 0;
+}
+
+static void xcd_dwarf_load_fde_index(xcd_dwarf_t *self)
+{
+    xcd_dwarf_fde_index_t *index = NULL, *new_index;
+    size_t                 index_count = 0;
+    size_t                 index_cap = 0;
+    xcd_dwarf_cie_t       *cie;
+    uintptr_t              pc_start;
+    uintptr_t              pc_end;
+    size_t                 offset = self->entries_offset;
+    size_t                 next_offset;
+    uintptr_t              max_end = 0;
+    size_t                 i;
+
+    while(offset < self->entries_end)
+    {
+        if(0 == xcd_dwarf_read_fde_header(self, offset, &cie, &pc_start, &pc_end, &next_offset) && pc_start < pc_end)
+        {
+            if(index_count == index_cap)
+            {
+                index_cap = (0 == index_cap ? 256 : index_cap * 2);
+                if(NULL == (new_index = xcd_arena_heap_realloc(index, index_cap * sizeof(xcd_dwarf_fde_index_t)))) goto err;
+                index = new_index;
+            }
+            index[index_count].pc_start = pc_start;
+            index[index_count].pc_end = pc_end;
+            index[index_count].offset = offset;
+            index_count++;
+        }
+
+        //the offset must go forward
+        if(next_offset <= offset) goto err;
+        offset = next_offset;
+    }
+
+    if(index_count > 0)
+        qsort(index, index_count, sizeof(xcd_dwarf_fde_index_t), xcd_dwarf_fde_index_cmp);
+
+    //running max of the PC ends, so the lookup knows how far back an FDE may still cover pc
+    for(i = 0; i < index_count; i++)
+    {
+        if(index[i].pc_end > max_end) max_end = index[i].pc_end;
+        index[i].max_end = max_end;
+    }
+
+    self->fde_index = index;
+    self->fde_index_count = index_count;
+    return;
+
+ err:
+    //using linear search
+    if(NULL != index) xcd_arena_heap_free(index);
+}
+
 static xcd_dwarf_fde_t *xcd_dwarf_get_fde_no_hdr(xcd_dwarf_t *self, uintptr_t pc)
 {
     xcd_dwarf_fde_t *fde = NULL;
     size_t           offset = self->entries_offset;
+    size_t           first = 0;
+    size_t           last;
+    size_t           cur;
+    size_t           found;
+
+    //build the sorted FDE index (only once)
+    if(!self->fde_index_loaded)
+    {
+        self->fde_index_loaded = 1;
+        xcd_dwarf_load_fde_index(self);
+    }
+
+    if(NULL != self->fde_index)
+    {
+        //binary search for the first FDE which starts after pc
+        last = self->fde_index_count;
+        while(first < last)
+        {
+            cur = first + (last - first) / 2;
+            if(self->fde_index[cur].pc_start <= pc)
+                first = cur + 1;
+            else
+                last = cur;
+        }
+
+        //walk back over all the FDEs which start at or before pc and may still cover it
+        //(nested or overlapping ranges), keep the first one in the section as the linear search does
+        found = self->fde_index_count;
+        for(cur = last; cur > 0 && self->fde_index[cur - 1].max_end > pc; cur--)
+        {
+            if(pc >= self->fde_index[cur - 1].pc_end) continue;
+            if(found == self->fde_index_count || self->fde_index[cur - 1].offset < self->fde_index[found].offset) found = cur - 1;
+        }
+        if(found == self->fde_index_count) return NULL;
+
+        offset = self->fde_index[found].offset;
+        return xcd_dwarf_get_fde_from_offset(self, &offset, pc);
+    }
 
     while(offset < self->entries_end)
     {
@@ -912,6 +1174,44 @@ static xcd_dwarf_fde_t *xcd_dwarf_get_fde_no_hdr(xcd_dwarf_t *self, uintptr_t pc
     return fde;
 }
 
+//binary search in the local copy of the table (DW_EH_PE_datarel|DW_EH_PE_sdata4)
+static int xcd_dwarf_get_fde_offset_from_pc_in_table(xcd_dwarf_t *self, uintptr_t pc, size_t *fde_offset)
+{
+    const int32_t *table = self->eh_frame_hdr_table;
+    size_t         first = 0;
+    size_t         last = self->eh_frame_hdr_fde_count;
+    size_t         cur;
+    uintptr_t      cur_pc;
+
+    while(first < last)
+    {
+        cur = (first + last) / 2;
+
+        //get current pc
+        cur_pc = (uintptr_t)((uint64_t)((int64_t)table[cur * 2]) + self->memory_data_offset) + self->hdr_load_bias;
+
+        if(pc == cur_pc)
+        {
+            //get fde offset
+            *fde_offset = (size_t)((uint64_t)((int64_t)table[cur * 2 + 1]) + self->memory_data_offset);
+            return 0;
+        }
+        else if(pc < cur_pc)
+            last = cur;
+        else
+            first = cur + 1;
+    }
+
+    if(last != 0)
+    {
+        //get fde offset
+        *fde_offset = (size_t)((uint64_t)((int64_t)table[(last - 1) * 2 + 1]) + self->memory_data_offset);
+        return 0;
+    }
+
+    return XCC_ERRNO_NOTFND;
+}
+
 static int xcd_dwarf_get_fde_offset_from_pc(xcd_dwarf_t *self, uintptr_t pc, size_t *fde_offset)
 {
     int r;
@@ -924,6 +1224,9 @@ static int xcd_dwarf_get_fde_offset_from_pc(xcd_dwarf_t *self, uintptr_t pc, siz
     int is_rel_encoded = ((self->eh_frame_hdr_table_encoding & 0x70) <= DW_EH_PE_funcrel &&
                           (self->eh_frame_hdr_table_encoding & 0x70) > 0) ? 1 : 0;
 
+    if(NULL != self->eh_frame_hdr_table)
+        return xcd_dwarf_get_fde_offset_from_pc_in_table(self, pc, fde_offset);
+
     while(first < last)
     {
         cur = (first + last) / 2;
@@ -975,14 +1278,32 @@ static xcd_dwarf_fde_t *xcd_dwarf_get_fde_with_hdr(xcd_dwarf_t *self, uintptr_t
 
 static xcd_dwarf_fde_t *xcd_dwarf_get_fde(xcd_dwarf_t *self, uintptr_t pc)
 {
+    xcd_dwarf_fde_t  fde_key = {.pc_start = pc, .pc_end = pc + 1};
+    xcd_dwarf_fde_t *fde = NULL;
+
+    //check cache
+    if(NULL != (fde = RB_FIND(xcd_dwarf_fde_tree, &(self->fde_cache), &fde_key))) return fde;
+
     switch(self->type)
     {
     case XCD_DWARF_TYPE_DEBUG_FRAME:
     case XCD_DWARF_TYPE_EH_FRAME:
-        return xcd_dwarf_get_fde_no_hdr(self, pc);
+        fde = xcd_dwarf_get_fde_no_hdr(self, pc);
+        break;
     case XCD_DWARF_TYPE_EH_FRAME_HDR:
-        return xcd_dwarf_get_fde_with_hdr(self, pc);
+        fde = xcd_dwarf_get_fde_with_hdr(self, pc);
+        break;
     }
+    if(NULL == fde) return NULL;
+
+    //save to cache (until the cache is full)
+    if(self->fde_cache_count < XCD_DWARF_FDE_CACHE_MAX && NULL == RB_INSERT(xcd_dwarf_fde_tree, &(self->fde_cache), fde))
+    {
+        fde->cached = 1;
+        self->fde_cache_count++;
+    }
+
+    return fde;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -1012,7 +1333,7 @@ static xcd_dwarf_loc_t *xcd_dwarf_get_loc(xcd_dwarf_t *self, xcd_dwarf_fde_t *fd
     //start from instructions in CIE
     self->memory_cur_offset = cie_instr_start;
 
-    if(NULL == (loc_init = calloc(1, sizeof(xcd_dwarf_loc_t)))) return NULL;
+    if(NULL == (loc_init = xcd_arena_heap_calloc(1, sizeof(xcd_dwarf_loc_t)))) return NULL;
     loc = loc_init;
     
     while(1)
@@ -1023,7 +1344,7 @@ static xcd_dwarf_loc_t *xcd_dwarf_get_loc(xcd_dwarf_t *self, xcd_dwarf_fde_t *fd
         {
             if(self->memory_cur_offset >= cie_instr_end)
             {
-                if(NULL == (loc_pc = calloc(1, sizeof(xcd_dwarf_loc_t)))) goto err;
+                if(NULL == (loc_pc = xcd_arena_heap_calloc(1, sizeof(xcd_dwarf_loc_t)))) goto err;
                 loc = loc_pc;
 
                 //jump to FDE instructions
@@ -1119,7 +1440,7 @@ static xcd_dwarf_loc_t *xcd_dwarf_get_loc(xcd_dwarf_t *self, xcd_dwarf_fde_t *fd
                 loc->reg_rules[operands[0]].values[0] = operands[1];
                 break;
             case 0x0a: //DW_CFA_remember_state
-                if(NULL == (loc_node = malloc(sizeof(xcd_dwarf_loc_node_t)))) goto err;
+                if(NULL == (loc_node = xcd_arena_heap_malloc(sizeof(xcd_dwarf_loc_node_t)))) goto err;
                 memcpy(&(loc_node->loc), loc, sizeof(xcd_dwarf_loc_t));
                 TAILQ_INSERT_HEAD(&loc_node_stack, loc_node, link);
                 break;
@@ -1132,7 +1453,7 @@ static xcd_dwarf_loc_t *xcd_dwarf_get_loc(xcd_dwarf_t *self, xcd_dwarf_fde_t *fd
                 {
                     memcpy(loc, &(loc_node->loc), sizeof(xcd_dwarf_loc_t));
                     TAILQ_REMOVE(&loc_node_stack, loc_node, link);
-                    free(loc_node);
+                    xcd_arena_heap_free(loc_node);
                 }
                 break;
             case 0x0c: //DW_CFA_def_cfa
@@ -1203,20 +1524,20 @@ static xcd_dwarf_loc_t *xcd_dwarf_get_loc(xcd_dwarf_t *self, xcd_dwarf_fde_t *fd
     TAILQ_FOREACH_SAFE(loc_node, &loc_node_stack, link, loc_node_tmp)
     {
         TAILQ_REMOVE(&loc_node_stack, loc_node, link);
-        free(loc_node);
+        xcd_arena_heap_free(loc_node);
     }
-    if(loc == loc_pc && NULL != loc_init) free(loc_init);
+    if(loc == loc_pc && NULL != loc_init) xcd_arena_heap_free(loc_init);
     return loc;
     
  err:
     if(NULL != loc_init)
     {
-        free(loc_init);
+        xcd_arena_heap_free(loc_init);
         loc_init = NULL;
     }
     if(NULL != loc_pc)
     {
-        free(loc_pc);
+        xcd_arena_heap_free(loc_pc);
         loc_pc = NULL;
     }
     loc = NULL;
@@ -1527,7 +1848,8 @@ static int xcd_dwarf_eval_expression(xcd_dwarf_t *self, xcd_regs_t *regs, size_t
 }
 #pragma clang diagnostic pop
     
-static int xcd_dwarf_eval(xcd_dwarf_t *self, xcd_dwarf_fde_t *fde, xcd_dwarf_loc_t *loc, xcd_regs_t *regs, int *finished)
+static int xcd_dwarf_eval(xcd_dwarf_t *self, xcd_dwarf_fde_t *fde, xcd_dwarf_loc_rule_t *cfa_rule, xcd_dwarf_loc_rule_t *reg_rules,
+                          xcd_regs_t *regs, int *finished)
 {
     int        r;
     size_t     i;
@@ -1537,15 +1859,15 @@ static int xcd_dwarf_eval(xcd_dwarf_t *self, xcd_dwarf_fde_t *fde, xcd_dwarf_loc
     int        return_address_undefined = 0;
 
     //CFA
-    switch(loc->cfa_rule.type)
+    switch(cfa_rule->type)
     {
     case DW_LOC_REGISTER:
-        if(loc->cfa_rule.values[0] >= XCD_REGS_MACHINE_NUM) return XCC_ERRNO_RANGE;
-        cfa = (uintptr_t)(regs_orig.r[loc->cfa_rule.values[0]] + loc->cfa_rule.values[1]);
+        if(cfa_rule->values[0] >= XCD_REGS_MACHINE_NUM) return XCC_ERRNO_RANGE;
+        cfa = (uintptr_t)(regs_orig.r[cfa_rule->values[0]] + cfa_rule->values[1]);
         break;
     case DW_LOC_VAL_EXPRESSION:
-        if(0 != (r = xcd_dwarf_eval_expression(self, &regs_orig, (size_t)(loc->cfa_rule.values[1] - loc->cfa_rule.values[0]),
-                                               (size_t)(loc->cfa_rule.values[1]), &value))) return r;
+        if(0 != (r = xcd_dwarf_eval_expression(self, &regs_orig, (size_t)(cfa_rule->values[1] - cfa_rule->values[0]),
+                                               (size_t)(cfa_rule->values[1]), &value))) return r;
         cfa = value;
         break;
     default:
@@ -1555,26 +1877,26 @@ static int xcd_dwarf_eval(xcd_dwarf_t *self, xcd_dwarf_fde_t *fde, xcd_dwarf_loc
     //regs
     for(i = 0; i < XCD_REGS_MACHINE_NUM; i++)
     {
-        switch(loc->reg_rules[i].type)
+        switch(reg_rules[i].type)
         {
         case DW_LOC_OFFSET:
-            if(0 != (r = xcd_util_ptrace_read_fully(self->pid, (uintptr_t)(cfa + loc->reg_rules[i].values[0]), &(regs->r[i]), sizeof(regs->r[i])))) return r;
+            if(0 != (r = xcd_util_ptrace_read_fully(self->pid, (uintptr_t)(cfa + reg_rules[i].values[0]), &(regs->r[i]), sizeof(regs->r[i])))) return r;
             break;
         case DW_LOC_VAL_OFFSET:
-            regs->r[i] = (uintptr_t)(cfa + loc->reg_rules[i].values[0]);
+            regs->r[i] = (uintptr_t)(cfa + reg_rules[i].values[0]);
             break;
         case DW_LOC_REGISTER:
-            if(loc->reg_rules[i].values[0] >= XCD_REGS_MACHINE_NUM) return XCC_ERRNO_RANGE;
-            regs->r[i] = (uintptr_t)(regs_orig.r[loc->reg_rules[i].values[0]] + loc->reg_rules[i].values[1]);
+            if(reg_rules[i].values[0] >= XCD_REGS_MACHINE_NUM) return XCC_ERRNO_RANGE;
+            regs->r[i] = (uintptr_t)(regs_orig.r[reg_rules[i].values[0]] + reg_rules[i].values[1]);
             break;
         case DW_LOC_EXPRESSION:
-            if(0 != (r = xcd_dwarf_eval_expression(self, &regs_orig, (size_t)(loc->reg_rules[i].values[1] - loc->reg_rules[i].values[0]),
-                                                   (size_t)(loc->reg_rules[i].values[1]), &value))) return r;
+            if(0 != (r = xcd_dwarf_eval_expression(self, &regs_orig, (size_t)(reg_rules[i].values[1] - reg_rules[i].values[0]),
+                                                   (size_t)(reg_rules[i].values[1]), &value))) return r;
             if(0 != (r = xcd_util_ptrace_read_fully(self->pid, value, &(regs->r[i]), sizeof(regs->r[i])))) return r;
             break;
         case DW_LOC_VAL_EXPRESSION:
-            if(0 != (r = xcd_dwarf_eval_expression(self, &regs_orig, (size_t)(loc->reg_rules[i].values[1] - loc->reg_rules[i].values[0]),
-                                                   (size_t)(loc->reg_rules[i].values[1]), &value))) return r;
+            if(0 != (r = xcd_dwarf_eval_expression(self, &regs_orig, (size_t)(reg_rules[i].values[1] - reg_rules[i].values[0]),
+                                                   (size_t)(reg_rules[i].values[1]), &value))) return r;
             regs->r[i] = value;
             break;
         case DW_LOC_UNDEFINED:
@@ -1600,6 +1922,33 @@ static int xcd_dwarf_eval(xcd_dwarf_t *self, xcd_dwarf_fde_t *fde, xcd_dwarf_loc
 //////////////////////////////////////////////////////////////////////
 // create DWARF object
 
+static void xcd_dwarf_load_eh_frame_hdr_table(xcd_dwarf_t *self)
+{
+    const void *ptr = NULL;
+    int32_t    *table;
+    size_t      table_size;
+
+    if(self->eh_frame_hdr_fde_count > SIZE_MAX / (sizeof(int32_t) * 2)) return;
+    table_size = self->eh_frame_hdr_fde_count * sizeof(int32_t) * 2;
+
+    //try to use the data in local memory directly
+    if(xcd_memory_peek(self->memory, self->entries_offset, &ptr) >= table_size &&
+       0 == ((uintptr_t)ptr & (sizeof(int32_t) - 1)))
+    {
+        self->eh_frame_hdr_table = (const int32_t *)ptr;
+        return;
+    }
+
+    //copy the table to local memory
+    if(NULL == (table = xcd_arena_heap_malloc(table_size))) return;
+    if(0 != xcd_memory_read_fully(self->memory, self->entries_offset, table, table_size))
+    {
+        xcd_arena_heap_free(table);
+        return;
+    }
+    self->eh_frame_hdr_table = table;
+}
+
 static int xcd_dwarf_init_eh_frame_hdr(xcd_dwarf_t *self)
 {
     int      r;
@@ -1662,6 +2011,10 @@ static int xcd_dwarf_init_eh_frame_hdr(xcd_dwarf_t *self)
 
     //set entries_offset to the start of binary search table
     self->entries_offset = self->memory_cur_offset;
+
+    //load the whole binary search table for the most common encoding
+    if((DW_EH_PE_datarel | DW_EH_PE_sdata4) == table_encoding)
+        xcd_dwarf_load_eh_frame_hdr_table(self);
     
     return 0;
 }
@@ -1671,12 +2024,14 @@ int xcd_dwarf_create(xcd_dwarf_t **self, xcd_memory_t *memory, pid_t pid, uintpt
 {
     int r = 0;
     
-    if(NULL == (*self = calloc(1, sizeof(xcd_dwarf_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (*self = xcd_arena_calloc(1, sizeof(xcd_dwarf_t)))) return XCC_ERRNO_NOMEM;
     (*self)->type = type;
     (*self)->pid = pid;
     (*self)->load_bias = load_bias;
     (*self)->hdr_load_bias = hdr_load_bias;
     RB_INIT(&((*self)->cie_cache));
+    RB_INIT(&((*self)->fde_cache));
+    RB_INIT(&((*self)->loc_cache));
     (*self)->memory = memory;
     (*self)->memory_cur_offset = offset;
     (*self)->memory_pc_offset = (size_t)-1;
@@ -1692,11 +2047,7 @@ int xcd_dwarf_create(xcd_dwarf_t **self, xcd_memory_t *memory, pid_t pid, uintpt
     return 0;
 
  err:
-    if(NULL != *self)
-    {
-        free(*self);
-        *self = NULL;
-    }
+    *self = NULL;
     return r;
 }
 
@@ -1705,9 +2056,11 @@ int xcd_dwarf_create(xcd_dwarf_t **self, xcd_memory_t *memory, pid_t pid, uintpt
 
 int xcd_dwarf_step(xcd_dwarf_t *self, xcd_regs_t *regs, uintptr_t pc, int *finished)
 {
-    xcd_dwarf_fde_t *fde = NULL;
-    xcd_dwarf_loc_t *loc = NULL;
-    int              r   = XCC_ERRNO_NOTFND;
+    xcd_dwarf_fde_t       *fde = NULL;
+    xcd_dwarf_loc_t       *loc = NULL;
+    xcd_dwarf_loc_cache_t  loc_cache_key;
+    xcd_dwarf_loc_cache_t *loc_cache = NULL;
+    int                    r   = XCC_ERRNO_NOTFND;
 
     //find FDE & CIE from PC
     if(NULL == (fde = xcd_dwarf_get_fde(self, pc)))
@@ -1718,17 +2071,36 @@ int xcd_dwarf_step(xcd_dwarf_t *self, xcd_regs_t *regs, uintptr_t pc, int *finis
         goto end;
     }
     
-    //find LOCATION in the FDE from PC
-    if(NULL == (loc = xcd_dwarf_get_loc(self, fde, pc)))
+    //check LOCATION cache
+    loc_cache_key.fde_instructions_offset = fde->cfa_instructions_offset;
+    loc_cache_key.pc = pc;
+    if(NULL == (loc_cache = RB_FIND(xcd_dwarf_loc_tree, &(self->loc_cache), &loc_cache_key)))
     {
+        //find LOCATION in the FDE from PC
+        if(NULL == (loc = xcd_dwarf_get_loc(self, fde, pc)))
+        {
 #if XCD_DWARF_DEBUG
-        XCD_LOG_DEBUG("DWARF: get LOC failed, step_pc=%"PRIxPTR, pc);
+            XCD_LOG_DEBUG("DWARF: get LOC failed, step_pc=%"PRIxPTR, pc);
 #endif
-        goto end;
+            goto end;
+        }
+
+        //save to cache (until the cache is full)
+        if(self->loc_cache_count < XCD_DWARF_LOC_CACHE_MAX && NULL != (loc_cache = xcd_arena_alloc(sizeof(xcd_dwarf_loc_cache_t))))
+        {
+            loc_cache->fde_instructions_offset = loc_cache_key.fde_instructions_offset;
+            loc_cache->pc = loc_cache_key.pc;
+            loc_cache->cfa_rule = loc->cfa_rule;
+            memcpy(loc_cache->reg_rules, loc->reg_rules, sizeof(loc_cache->reg_rules));
+            RB_INSERT(xcd_dwarf_loc_tree, &(self->loc_cache), loc_cache);
+            self->loc_cache_count++;
+        }
     }
 
     //eval the actual registers
-    if(0 != (r = xcd_dwarf_eval(self, fde, loc, regs, finished)))
+    if(0 != (r = (NULL != loc_cache ?
+                  xcd_dwarf_eval(self, fde, &(loc_cache->cfa_rule), loc_cache->reg_rules, regs, finished) :
+                  xcd_dwarf_eval(self, fde, &(loc->cfa_rule), loc->reg_rules, regs, finished))))
     {
 #if XCD_DWARF_DEBUG
         XCD_LOG_DEBUG("DWARF: eval failed, step_pc=%"PRIxPTR, pc);
@@ -1740,8 +2112,8 @@ int xcd_dwarf_step(xcd_dwarf_t *self, xcd_regs_t *regs, uintptr_t pc, int *finis
     r = 0;
 
  end:
-    if(NULL != fde) free(fde);
-    if(NULL != loc) free(loc);
+    if(NULL != loc) xcd_arena_heap_free(loc);
+    if(NULL != fde && !fde->cached) xcd_arena_heap_free(fde);
     return r;
 }
 
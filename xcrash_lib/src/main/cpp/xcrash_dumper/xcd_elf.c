@@ -35,6 +35,7 @@
 #include "xcd_elf_interface.h"
 #include "xcd_memory.h"
 #include "xcd_log.h"
+#include "xcd_arena.h"
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
@@ -82,14 +83,14 @@ int xcd_elf_create(xcd_elf_t **self, pid_t pid, xcd_memory_t *memory)
 {
     int r;
     
-    if(NULL == (*self = calloc(1, sizeof(xcd_elf_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (*self = xcd_arena_calloc(1, sizeof(xcd_elf_t)))) return XCC_ERRNO_NOMEM;
     (*self)->pid = pid;
     (*self)->memory = memory;
 
     //create ELF interface, save load bias
     if(0 != (r = xcd_elf_interface_create(&((*self)->interface), pid, memory, &((*self)->load_bias))))
     {
-        free(*self);
+        *self = NULL;
         return r;
     }
 
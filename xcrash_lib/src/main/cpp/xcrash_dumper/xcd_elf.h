@@ -40,6 +40,7 @@ int xcd_elf_create(xcd_elf_t **self, pid_t pid, xcd_memory_t *memory);
 
 int xcd_elf_step(xcd_elf_t *self, uintptr_t rel_pc, uintptr_t step_pc, xcd_regs_t *regs, int *finished, int *sigreturn);
 
+//the returned name should be freed by xcd_arena_heap_free()
 int xcd_elf_get_function_info(xcd_elf_t *self, uintptr_t addr, char **name, size_t *name_offset);
 int xcd_elf_get_symbol_addr(xcd_elf_t *self, const char *name, uintptr_t *addr);
 
@@ -37,6 +37,7 @@
 #include "xcd_memory.h"
 #include "xcd_log.h"
 #include "xcd_util.h"
+#include "xcd_arena.h"
 #include "queue.h"
 
 #pragma clang diagnostic push
@@ -64,6 +65,29 @@ typedef struct xcd_elf_strtab
 #pragma clang diagnostic pop
 typedef TAILQ_HEAD(xcd_elf_strtab_queue, xcd_elf_strtab,) xcd_elf_strtab_queue_t;
 
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct xcd_elf_load
+{
+    uintptr_t vaddr;
+    size_t    offset;
+    size_t    size;
+    TAILQ_ENTRY(xcd_elf_load,) link;
+} xcd_elf_load_t;
+#pragma clang diagnostic pop
+typedef TAILQ_HEAD(xcd_elf_load_queue, xcd_elf_load,) xcd_elf_load_queue_t;
+
+//function symbol (STT_FUNC) in the sorted index
+typedef struct xcd_elf_func
+{
+    uintptr_t start;
+    size_t    size;
+    size_t    name_offset;
+    size_t    name_end;
+    size_t    order;   //original order in the symbol tables, preferred among overlapping functions
+    uintptr_t max_end; //the largest (start + size) of this and all the previous functions
+} xcd_elf_func_t;
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
 struct xcd_elf_interface
@@ -77,6 +101,11 @@ struct xcd_elf_interface
     //symbols (.dynsym with .dynstr, .symtab with .strtab)
     xcd_elf_symbols_queue_t  symbolsq;
 
+    //function symbols sorted by start address (loaded on first use)
+    xcd_elf_func_t          *funcs;
+    size_t                   funcs_num;
+    int                      funcs_loaded;
+
     //string tables
     xcd_elf_strtab_queue_t   strtabq;
 
@@ -110,6 +139,18 @@ struct xcd_elf_interface
     //.dynamic
     size_t                   dynamic_offset;
     size_t                   dynamic_size;
+
+    //PT_LOAD segments (for converting vaddr in .dynamic to offset)
+    xcd_elf_load_queue_t     loadq;
+
+    //DT_GNU_HASH / DT_HASH with DT_SYMTAB and DT_STRTAB (loaded on first use)
+    size_t                   gnu_hash_offset;
+    size_t                   sysv_hash_offset;
+    size_t                   dynsym_offset;
+    size_t                   dynsym_entry_size;
+    size_t                   dynstr_offset;
+    size_t                   dynstr_size;
+    int                      hash_loaded;
 };
 #pragma clang diagnostic pop
 
@@ -155,10 +196,11 @@ static int xcd_elf_interface_check_valid(ElfW(Ehdr) *ehdr)
 
 static int xcd_elf_interface_read_program_headers(xcd_elf_interface_t *self, ElfW(Ehdr) *ehdr, uintptr_t *load_bias)
 {
-    size_t     i;
-    ElfW(Phdr) phdr;
-    int        try_save_load_bias = 0;
-    int        r;
+    size_t          i;
+    ElfW(Phdr)      phdr;
+    xcd_elf_load_t *load, *load_tmp;
+    int             try_save_load_bias = 0;
+    int             r;
     
     for(i = 0; i < ehdr->e_phnum * ehdr->e_phentsize; i += ehdr->e_phentsize)
     {
@@ -172,6 +214,17 @@ static int xcd_elf_interface_read_program_headers(xcd_elf_interface_t *self, Elf
         {
         case PT_LOAD:
             {
+                //save all the loadable segments
+                if(NULL == (load = xcd_arena_alloc(sizeof(xcd_elf_load_t))))
+                {
+                    r = XCC_ERRNO_NOMEM;
+                    goto err;
+                }
+                load->vaddr = phdr.p_vaddr;
+                load->offset = phdr.p_offset;
+                load->size = phdr.p_filesz;
+                TAILQ_INSERT_TAIL(&(self->loadq), load, link);
+
                 if(0 == (phdr.p_flags & PF_X)) continue;
 
                 if(!try_save_load_bias && phdr.p_vaddr > phdr.p_offset)
@@ -202,6 +255,10 @@ static int xcd_elf_interface_read_program_headers(xcd_elf_interface_t *self, Elf
     return 0;
 
  err:
+    TAILQ_FOREACH_SAFE(load, &(self->loadq), link, load_tmp)
+    {
+        TAILQ_REMOVE(&(self->loadq), load, link);
+    }
     return r;
 }
 
@@ -261,7 +318,7 @@ static int xcd_elf_interface_read_section_headers(xcd_elf_interface_t *self, Elf
                 if(SHT_STRTAB != str_shdr.sh_type) continue;
 
                 //save symbols and the associated strtab
-                if(NULL == (symbols = malloc(sizeof(xcd_elf_symbols_t))))
+                if(NULL == (symbols = xcd_arena_alloc(sizeof(xcd_elf_symbols_t))))
                 {
                     r = XCC_ERRNO_NOMEM;
                     goto err;
@@ -276,7 +333,7 @@ static int xcd_elf_interface_read_section_headers(xcd_elf_interface_t *self, Elf
             }
         case SHT_STRTAB:
             {
-                if(NULL == (strtab = malloc(sizeof(xcd_elf_strtab_t))))
+                if(NULL == (strtab = xcd_arena_alloc(sizeof(xcd_elf_strtab_t))))
                 {
                     r = XCC_ERRNO_NOMEM;
                     goto err;
@@ -330,12 +387,10 @@ static int xcd_elf_interface_read_section_headers(xcd_elf_interface_t *self, Elf
     TAILQ_FOREACH_SAFE(symbols, &(self->symbolsq), link, symbols_tmp)
     {
         TAILQ_REMOVE(&(self->symbolsq), symbols, link);
-        free(symbols);
     }
     TAILQ_FOREACH_SAFE(strtab, &(self->strtabq), link, strtab_tmp)
     {
         TAILQ_REMOVE(&(self->strtabq), strtab, link);
-        free(strtab);
     }
     return r;
 }
@@ -352,16 +407,16 @@ int xcd_elf_interface_create(xcd_elf_interface_t **self, pid_t pid, xcd_memory_t
     if(0 != (r = xcd_elf_interface_check_valid(&ehdr))) return r;
 
     //init
-    if(NULL == (*self = calloc(1, sizeof(xcd_elf_interface_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (*self = xcd_arena_calloc(1, sizeof(xcd_elf_interface_t)))) return XCC_ERRNO_NOMEM;
     (*self)->pid = pid;
     (*self)->memory = memory;
     TAILQ_INIT(&((*self)->symbolsq));
     TAILQ_INIT(&((*self)->strtabq));
+    TAILQ_INIT(&((*self)->loadq));
 
     //read program headers, save and return load_bias
     if(0 != (r = xcd_elf_interface_read_program_headers(*self, &ehdr, load_bias)))
     {
-        free(*self);
         *self = NULL;
         return r;
     }
@@ -412,14 +467,17 @@ xcd_elf_interface_t *xcd_elf_interface_gnu_create(xcd_elf_interface_t *self)
 
     //dump xz data
     src_size = self->gnu_debugdata_size;
-    if(NULL == (src = malloc(src_size))) goto err;
+    if(NULL == (src = xcd_arena_heap_malloc(src_size))) goto err;
     if(0 != xcd_memory_read_fully(self->memory, self->gnu_debugdata_offset, src, src_size)) goto err;
 
     //xz decompress
     if(0 != xcd_util_xz_decompress(src, src_size, &dst, &dst_size)) goto err;
+    xcd_arena_heap_free(src);
+    src = NULL;
 
-    //create memory object
+    //create memory object (it owns dst from now on)
     if(0 != xcd_memory_create_from_buf(&memory, dst, dst_size)) goto err;
+    dst = NULL;
 
     //create ELF interface from .gnu_debugdata
     if(0 != xcd_elf_interface_create(&gnu, self->pid, memory, NULL)) goto err;
@@ -431,8 +489,8 @@ xcd_elf_interface_t *xcd_elf_interface_gnu_create(xcd_elf_interface_t *self)
  err:
     XCD_LOG_WARN("ELF: create GNU interface FAILED");
     if(NULL != memory) xcd_memory_destroy(&memory);
-    if(NULL != dst) free(dst);
-    if(NULL != src) free(src);
+    if(NULL != dst) xcd_arena_heap_free(dst);
+    if(NULL != src) xcd_arena_heap_free(src);
     return NULL;
 }
 
@@ -490,52 +548,331 @@ int xcd_elf_interface_arm_exidx_step(xcd_elf_interface_t *self, uintptr_t step_p
 }
 #endif
 
-int xcd_elf_interface_get_function_info(xcd_elf_interface_t *self, uintptr_t addr, char **name, size_t *name_offset)
+static int xcd_elf_interface_func_cmp(const void *a, const void *b)
+{
+    const xcd_elf_func_t *fa = (const xcd_elf_func_t *)a;
+    const xcd_elf_func_t *fb = (const xcd_elf_func_t *)b;
+
+    if(fa->start != fb->start) return (fa->start > fb->start ? 1 : -1);
+    if(fa->order != fb->order) return (fa->order > fb->order ? 1 : -1);
+    return 0;
+}
+
+static int xcd_elf_interface_load_funcs_from_symbols(xcd_elf_interface_t *self, xcd_elf_symbols_t *symbols,
+                                                     xcd_elf_func_t **funcs, size_t *funcs_num)
+{
+    xcd_elf_func_t *new_funcs;
+    uint8_t        *data = NULL;
+    size_t          data_size;
+    size_t          offset;
+    ElfW(Sym)       sym;
+
+    if(symbols->sym_entry_size < sizeof(ElfW(Sym)) || symbols->sym_end <= symbols->sym_offset) return 0;
+    data_size = symbols->sym_end - symbols->sym_offset;
+
+    //make room for all the symbols in this table
+    if(NULL == (new_funcs = xcd_arena_heap_realloc(*funcs, (*funcs_num + data_size / symbols->sym_entry_size) * sizeof(xcd_elf_func_t))))
+        return XCC_ERRNO_NOMEM;
+    *funcs = new_funcs;
+
+    //read the whole .symtab / .dynsym at once
+    if(NULL != (data = xcd_arena_heap_malloc(data_size)) &&
+       0 != xcd_memory_read_fully(self->memory, symbols->sym_offset, data, data_size))
+    {
+        xcd_arena_heap_free(data);
+        data = NULL;
+    }
+
+    for(offset = 0; offset + sizeof(ElfW(Sym)) <= data_size; offset += symbols->sym_entry_size)
+    {
+        if(NULL != data)
+            memcpy(&sym, data + offset, sizeof(sym));
+        else if(0 != xcd_memory_read_fully(self->memory, symbols->sym_offset + offset, &sym, sizeof(sym)))
+            break; //fall back to reading one by one
+
+        if(sym.st_shndx == SHN_UNDEF || ELF_ST_TYPE(sym.st_info) != STT_FUNC || 0 == sym.st_size) continue;
+        if(symbols->str_offset + sym.st_name >= symbols->str_end) continue;
+
+        (*funcs)[*funcs_num].start = sym.st_value;
+        (*funcs)[*funcs_num].size = sym.st_size;
+        (*funcs)[*funcs_num].name_offset = symbols->str_offset + sym.st_name;
+        (*funcs)[*funcs_num].name_end = symbols->str_end;
+        (*funcs)[*funcs_num].order = *funcs_num;
+        (*funcs_num)++;
+    }
+
+    if(NULL != data) xcd_arena_heap_free(data);
+    return 0;
+}
+
+static void xcd_elf_interface_load_funcs(xcd_elf_interface_t *self)
 {
     xcd_elf_symbols_t *symbols;
-    size_t             offset;
-    size_t             start_offset;
-    size_t             end_offset;
-    size_t             str_offset;
-    ElfW(Sym)          sym;
-    char               buf[512];
+    xcd_elf_func_t    *funcs = NULL;
+    size_t             funcs_num = 0;
+    uintptr_t          max_end = 0;
+    size_t             i;
 
     TAILQ_FOREACH(symbols, &(self->symbolsq), link)
+        if(0 != xcd_elf_interface_load_funcs_from_symbols(self, symbols, &funcs, &funcs_num)) goto err;
+    if(0 == funcs_num) goto err;
+
+    //sort by start address
+    qsort(funcs, funcs_num, sizeof(xcd_elf_func_t), xcd_elf_interface_func_cmp);
+
+    //running max of the end addresses, so the lookup knows how far back a function may still cover addr
+    for(i = 0; i < funcs_num; i++)
     {
-        for(offset = symbols->sym_offset; offset < symbols->sym_end; offset += symbols->sym_entry_size)
-        {
-            if(0 != xcd_memory_read_fully(self->memory, offset, &sym, sizeof(sym))) break;
-            if(sym.st_shndx == SHN_UNDEF || ELF_ST_TYPE(sym.st_info) != STT_FUNC) continue;
-            
-            start_offset = sym.st_value;
-            end_offset = start_offset + sym.st_size;
-            if(addr < start_offset || addr >= end_offset) continue;
-            
-            *name_offset = addr - start_offset;
-            
-            str_offset = symbols->str_offset + sym.st_name;
-            if(str_offset >= symbols->str_end) continue;
-            
-            if(0 != xcd_memory_read_string(self->memory, str_offset, buf, sizeof(buf), symbols->str_end - str_offset)) continue;
-            if(NULL == (*name = strdup(buf))) break;
+        if(funcs[i].start + funcs[i].size > max_end) max_end = funcs[i].start + funcs[i].size;
+        funcs[i].max_end = max_end;
+    }
 
-            return 0;
-        }
+    //drop the room reserved for the skipped symbols
+    if(NULL == (self->funcs = xcd_arena_heap_realloc(funcs, funcs_num * sizeof(xcd_elf_func_t)))) self->funcs = funcs;
+    self->funcs_num = funcs_num;
+    return;
+
+ err:
+    if(NULL != funcs) xcd_arena_heap_free(funcs);
+}
+
+int xcd_elf_interface_get_function_info(xcd_elf_interface_t *self, uintptr_t addr, char **name, size_t *name_offset)
+{
+    xcd_elf_func_t *func = NULL;
+    size_t          first = 0;
+    size_t          last;
+    size_t          cur;
+    char            buf[512];
+
+    //build the index (only once)
+    if(!self->funcs_loaded)
+    {
+        self->funcs_loaded = 1;
+        xcd_elf_interface_load_funcs(self);
     }
 
+    //binary search for the first function which starts after addr
+    last = self->funcs_num;
+    while(first < last)
+    {
+        cur = first + (last - first) / 2;
+        if(self->funcs[cur].start <= addr)
+            first = cur + 1;
+        else
+            last = cur;
+    }
+
+    //walk back over all the functions which start at or before addr and may still cover it
+    //(nested, aliased or overlapping symbols), keep the first one in the symbol tables' order
+    for(cur = last; cur > 0 && self->funcs[cur - 1].max_end > addr; cur--)
+    {
+        if(addr - self->funcs[cur - 1].start >= self->funcs[cur - 1].size) continue;
+        if(NULL == func || self->funcs[cur - 1].order < func->order) func = &(self->funcs[cur - 1]);
+    }
+    if(NULL == func) goto not_found;
+
+    if(0 != xcd_memory_read_string(self->memory, func->name_offset, buf, sizeof(buf), func->name_end - func->name_offset)) goto not_found;
+    if(NULL == (*name = xcd_arena_heap_strdup(buf))) goto not_found;
+
+    *name_offset = addr - func->start;
+    return 0;
+
+ not_found:
     *name = NULL;
     *name_offset = 0;
     return XCC_ERRNO_NOTFND;
 }
 
+static int xcd_elf_interface_vaddr_to_offset(xcd_elf_interface_t *self, uintptr_t vaddr, size_t *offset)
+{
+    xcd_elf_load_t *load;
+
+    TAILQ_FOREACH(load, &(self->loadq), link)
+    {
+        if(vaddr >= load->vaddr && vaddr < load->vaddr + load->size)
+        {
+            *offset = load->offset + (vaddr - load->vaddr);
+            return 0;
+        }
+    }
+    return XCC_ERRNO_NOTFND;
+}
+
+static void xcd_elf_interface_load_hash(xcd_elf_interface_t *self)
+{
+    uintptr_t offset;
+    ElfW(Dyn) dyn;
+    uintptr_t gnu_hash_addr = 0;
+    uintptr_t sysv_hash_addr = 0;
+    uintptr_t dynsym_addr = 0;
+    uintptr_t dynstr_addr = 0;
+
+    if(0 == self->dynamic_offset || 0 == self->dynamic_size) return;
+
+    for(offset = self->dynamic_offset; offset < self->dynamic_offset + self->dynamic_size; offset += sizeof(dyn))
+    {
+        if(0 != xcd_memory_read_fully(self->memory, offset, &dyn, sizeof(dyn))) return;
+        if(DT_NULL == dyn.d_tag) break;
+        switch(dyn.d_tag)
+        {
+        case DT_GNU_HASH:
+            gnu_hash_addr = dyn.d_un.d_ptr;
+            break;
+        case DT_HASH:
+            sysv_hash_addr = dyn.d_un.d_ptr;
+            break;
+        case DT_SYMTAB:
+            dynsym_addr = dyn.d_un.d_ptr;
+            break;
+        case DT_SYMENT:
+            self->dynsym_entry_size = (size_t)(dyn.d_un.d_val);
+            break;
+        case DT_STRTAB:
+            dynstr_addr = dyn.d_un.d_ptr;
+            break;
+        case DT_STRSZ:
+            self->dynstr_size = (size_t)(dyn.d_un.d_val);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if(0 == dynsym_addr || 0 == dynstr_addr || 0 == self->dynstr_size) return;
+    if(0 != xcd_elf_interface_vaddr_to_offset(self, dynsym_addr, &(self->dynsym_offset))) return;
+    if(0 != xcd_elf_interface_vaddr_to_offset(self, dynstr_addr, &(self->dynstr_offset))) return;
+    if(self->dynsym_entry_size < sizeof(ElfW(Sym))) self->dynsym_entry_size = sizeof(ElfW(Sym));
+
+    if(0 != gnu_hash_addr && 0 != xcd_elf_interface_vaddr_to_offset(self, gnu_hash_addr, &(self->gnu_hash_offset)))
+        self->gnu_hash_offset = 0;
+    if(0 != sysv_hash_addr && 0 != xcd_elf_interface_vaddr_to_offset(self, sysv_hash_addr, &(self->sysv_hash_offset)))
+        self->sysv_hash_offset = 0;
+}
+
+//check whether the symbol in .dynsym matches the name
+static int xcd_elf_interface_check_dynsym(xcd_elf_interface_t *self, uint32_t idx, const char *name, size_t name_len, uintptr_t *addr)
+{
+    ElfW(Sym) sym;
+    char      buf[512];
+
+    if(name_len >= sizeof(buf)) return XCC_ERRNO_NOSPACE;
+
+    if(0 != xcd_memory_read_fully(self->memory, self->dynsym_offset + idx * self->dynsym_entry_size, &sym, sizeof(sym))) return XCC_ERRNO_MEM;
+    if(sym.st_shndx == SHN_UNDEF) return XCC_ERRNO_NOTFND;
+    if(sym.st_name + name_len >= self->dynstr_size) return XCC_ERRNO_NOTFND;
+
+    //compare symbol name (including the terminating '\0')
+    if(0 != xcd_memory_read_fully(self->memory, self->dynstr_offset + sym.st_name, buf, name_len + 1)) return XCC_ERRNO_MEM;
+    if(0 != memcmp(name, buf, name_len + 1)) return XCC_ERRNO_NOTFND;
+
+    *addr = sym.st_value;
+    return 0;
+}
+
+static int xcd_elf_interface_get_symbol_addr_by_gnu_hash(xcd_elf_interface_t *self, const char *name, uintptr_t *addr)
+{
+    uint32_t    hdr[4]; //nbuckets, symoffset, bloom_size, bloom_shift
+    ElfW(Addr)  bloom;
+    ElfW(Addr)  mask;
+    size_t      bloom_bits = sizeof(ElfW(Addr)) * 8;
+    size_t      buckets_offset, chains_offset;
+    uint32_t    hash = 5381;
+    uint32_t    idx, chain;
+    size_t      name_len = 0;
+    const char *c;
+
+    for(c = name; '\0' != *c; c++, name_len++)
+        hash = hash * 33 + (uint8_t)(*c);
+
+    if(0 != xcd_memory_read_fully(self->memory, self->gnu_hash_offset, hdr, sizeof(hdr))) return XCC_ERRNO_MEM;
+    if(0 == hdr[0] || 0 == hdr[2]) return XCC_ERRNO_NOTFND;
+    buckets_offset = self->gnu_hash_offset + sizeof(hdr) + sizeof(ElfW(Addr)) * hdr[2];
+    chains_offset = buckets_offset + sizeof(uint32_t) * hdr[0];
+
+    //check bloom filter
+    if(0 != xcd_memory_read_fully(self->memory, self->gnu_hash_offset + sizeof(hdr) + sizeof(ElfW(Addr)) * ((hash / bloom_bits) % hdr[2]),
+                                  &bloom, sizeof(bloom))) return XCC_ERRNO_MEM;
+    mask = ((ElfW(Addr))1 << (hash % bloom_bits)) | ((ElfW(Addr))1 << ((hash >> hdr[3]) % bloom_bits));
+    if((bloom & mask) != mask) return XCC_ERRNO_NOTFND;
+
+    //find the first symbol in bucket
+    if(0 != xcd_memory_read_fully(self->memory, buckets_offset + sizeof(uint32_t) * (hash % hdr[0]), &idx, sizeof(idx))) return XCC_ERRNO_MEM;
+    if(idx < hdr[1]) return XCC_ERRNO_NOTFND;
+
+    //walk through the chain
+    while(1)
+    {
+        if(0 != xcd_memory_read_fully(self->memory, chains_offset + sizeof(uint32_t) * (idx - hdr[1]), &chain, sizeof(chain))) return XCC_ERRNO_MEM;
+        if((hash | 1) == (chain | 1) && 0 == xcd_elf_interface_check_dynsym(self, idx, name, name_len, addr)) return 0;
+        if(chain & 1) break; //end of chain
+        idx++;
+    }
+
+    return XCC_ERRNO_NOTFND;
+}
+
+static int xcd_elf_interface_get_symbol_addr_by_sysv_hash(xcd_elf_interface_t *self, const char *name, uintptr_t *addr)
+{
+    uint32_t    hdr[2]; //nbucket, nchain
+    uint32_t    hash = 0, g;
+    uint32_t    idx;
+    uint32_t    i;
+    size_t      name_len = 0;
+    const char *c;
+
+    for(c = name; '\0' != *c; c++, name_len++)
+    {
+        hash = (hash << 4) + (uint8_t)(*c);
+        g = hash & 0xf0000000;
+        hash ^= g;
+        hash ^= g >> 24;
+    }
+
+    if(0 != xcd_memory_read_fully(self->memory, self->sysv_hash_offset, hdr, sizeof(hdr))) return XCC_ERRNO_MEM;
+    if(0 == hdr[0]) return XCC_ERRNO_NOTFND;
+
+    //find the first symbol in bucket
+    if(0 != xcd_memory_read_fully(self->memory, self->sysv_hash_offset + sizeof(hdr) + sizeof(uint32_t) * (hash % hdr[0]),
+                                  &idx, sizeof(idx))) return XCC_ERRNO_MEM;
+
+    //walk through the chain (limited by nchain, in case of a broken chain)
+    for(i = 0; 0 != idx && idx < hdr[1] && i < hdr[1]; i++)
+    {
+        if(0 == xcd_elf_interface_check_dynsym(self, idx, name, name_len, addr)) return 0;
+        if(0 != xcd_memory_read_fully(self->memory, self->sysv_hash_offset + sizeof(hdr) + sizeof(uint32_t) * (hdr[0] + idx),
+                                      &idx, sizeof(idx))) return XCC_ERRNO_MEM;
+    }
+
+    return XCC_ERRNO_NOTFND;
+}
+
 int xcd_elf_interface_get_symbol_addr(xcd_elf_interface_t *self, const char *name, uintptr_t *addr)
 {
     xcd_elf_symbols_t *symbols;
     size_t             offset;
     size_t             str_offset;
     ElfW(Sym)          sym;
+    const char        *str;
     char               buf[512];
 
+    //parse .dynamic for the hash tables (only once)
+    if(!self->hash_loaded)
+    {
+        self->hash_loaded = 1;
+        xcd_elf_interface_load_hash(self);
+    }
+
+    //lookup exported symbols via DT_GNU_HASH or DT_HASH
+    if(0 != self->gnu_hash_offset)
+    {
+        if(0 == xcd_elf_interface_get_symbol_addr_by_gnu_hash(self, name, addr)) return 0;
+    }
+    else if(0 != self->sysv_hash_offset)
+    {
+        if(0 == xcd_elf_interface_get_symbol_addr_by_sysv_hash(self, name, addr)) return 0;
+    }
+
+    //linear search in .symtab and .dynsym (for the local symbols)
     TAILQ_FOREACH(symbols, &(self->symbolsq), link)
     {
         for(offset = symbols->sym_offset; offset < symbols->sym_end; offset += symbols->sym_entry_size)
@@ -547,10 +884,14 @@ int xcd_elf_interface_get_symbol_addr(xcd_elf_interface_t *self, const char *nam
             //read .strtab / .dynstr
             str_offset = symbols->str_offset + sym.st_name;
             if(str_offset >= symbols->str_end) continue;
-            if(0 != xcd_memory_read_string(self->memory, str_offset, buf, sizeof(buf), symbols->str_end - str_offset)) continue;
+            if(NULL == (str = xcd_memory_get_string(self->memory, str_offset, symbols->str_end - str_offset)))
+            {
+                if(0 != xcd_memory_read_string(self->memory, str_offset, buf, sizeof(buf), symbols->str_end - str_offset)) continue;
+                str = buf;
+            }
 
             //compare symbol name
-            if(0 != strcmp(name, buf)) continue;
+            if(0 != strcmp(name, str)) continue;
 
             //found it
             *addr = sym.st_value;
@@ -624,7 +965,7 @@ char *xcd_elf_interface_get_so_name(xcd_elf_interface_t *self)
             soname_offset += strtab->offset;
             if(soname_offset >= strtab->offset + strtab_size) goto err;
             if(0 != xcd_memory_read_string(self->memory, soname_offset, buf, sizeof(buf), strtab->offset + strtab_size - soname_offset)) goto err;
-            if(NULL == (self->so_name = strdup(buf))) goto err;
+            if(NULL == (self->so_name = xcd_arena_strdup(buf))) goto err;
             return self->so_name;
         }
     }
@@ -45,6 +45,7 @@ int xcd_elf_interface_dwarf_step(xcd_elf_interface_t *self, uintptr_t step_pc, x
 int xcd_elf_interface_arm_exidx_step(xcd_elf_interface_t *self, uintptr_t step_pc, xcd_regs_t *regs, int *finished);
 #endif
 
+//the returned name should be freed by xcd_arena_heap_free()
 int xcd_elf_interface_get_function_info(xcd_elf_interface_t *self, uintptr_t addr, char **name, size_t *name_offset);
 int xcd_elf_interface_get_symbol_addr(xcd_elf_interface_t *self, const char *name, uintptr_t *addr);
 
@@ -39,6 +39,8 @@
 #include "xcd_md5.h"
 #include "xcd_util.h"
 #include "xcd_elf.h"
+#include "xcd_arena.h"
+#include "xcd_bin.h"
 #include "xcd_log.h"
 
 #define XCD_FRAMES_MAX         256
@@ -60,6 +62,17 @@ typedef struct xcd_frame
 #pragma clang diagnostic pop
 typedef TAILQ_HEAD(xcd_frame_queue, xcd_frame,) xcd_frame_queue_t;
 
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    uintptr_t sp;
+    size_t    words;
+    int       label;
+    uintptr_t data[XCD_FRAMES_STACK_WORDS];
+} xcd_frames_stack_segment_t;
+#pragma clang diagnostic pop
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
 struct xcd_frames
@@ -69,9 +82,20 @@ struct xcd_frames
     xcd_maps_t        *maps;
     xcd_frame_queue_t  frames;
     size_t             frames_num;
+    int                symbolize; //look up the function names (or leave it to the post-processor)
 };
 #pragma clang diagnostic pop
 
+//the function names of the frames live until the dumper exits
+static void xcd_frames_load_func_info(xcd_frame_t *frame, xcd_elf_t *elf, uintptr_t addr)
+{
+    char *func_name = NULL;
+
+    if(0 != xcd_elf_get_function_info(elf, addr, &func_name, &(frame->func_offset))) return;
+    frame->func_name = xcd_arena_strdup(func_name);
+    xcd_arena_heap_free(func_name);
+}
+
 static void xcd_frames_load(xcd_frames_t *self)
 {
     xcd_frame_t  *frame;
@@ -130,7 +154,7 @@ static void xcd_frames_load(xcd_frames_t *self)
         adjust_pc = 1;
 
         //create new frame
-        if(NULL == (frame = malloc(sizeof(xcd_frame_t)))) break;
+        if(NULL == (frame = xcd_arena_alloc(sizeof(xcd_frame_t)))) break;
         frame->map = map;
         frame->num = self->frames_num;
         frame->pc = cur_pc - pc_adjustment;
@@ -138,8 +162,8 @@ static void xcd_frames_load(xcd_frames_t *self)
         frame->sp = cur_sp;
         frame->func_name = NULL;
         frame->func_offset = 0;
-        if(NULL != elf)
-            xcd_elf_get_function_info(elf, step_pc, &(frame->func_name), &(frame->func_offset));
+        if(NULL != elf && self->symbolize)
+            xcd_frames_load_func_info(frame, elf, step_pc);
         TAILQ_INSERT_TAIL(&(self->frames), frame, link);
         self->frames_num++;
 
@@ -205,8 +229,6 @@ static void xcd_frames_load(xcd_frames_t *self)
                 {
                     TAILQ_REMOVE(&(self->frames), frame, link);
                     self->frames_num--;
-                    if(frame->func_name) free(frame->func_name);
-                    free(frame);
                 }
                 break;
             }
@@ -233,20 +255,38 @@ static void xcd_frames_load(xcd_frames_t *self)
     }
 }
 
-int xcd_frames_create(xcd_frames_t **self, xcd_regs_t *regs, xcd_maps_t *maps, pid_t pid)
+int xcd_frames_create(xcd_frames_t **self, xcd_regs_t *regs, xcd_maps_t *maps, pid_t pid, int symbolize)
 {
-    if(NULL == (*self = malloc(sizeof(xcd_frames_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (*self = xcd_arena_alloc(sizeof(xcd_frames_t)))) return XCC_ERRNO_NOMEM;
     (*self)->pid = pid;
     (*self)->regs = regs;
     (*self)->maps = maps;
     TAILQ_INIT(&((*self)->frames));
     (*self)->frames_num = 0;
+    (*self)->symbolize = symbolize;
     
     xcd_frames_load(*self);
     
     return 0;
 }
 
+//look up the function names after the frames were loaded without symbolization
+void xcd_frames_symbolize(xcd_frames_t *self)
+{
+    xcd_frame_t *frame;
+    xcd_elf_t   *elf;
+
+    if(self->symbolize) return;
+    self->symbolize = 1;
+
+    TAILQ_FOREACH(frame, &(self->frames), link)
+    {
+        if(NULL == frame->map || NULL != frame->func_name) continue;
+        if(NULL == (elf = xcd_map_get_elf(frame->map, self->pid, (void *)self->maps))) continue;
+        xcd_frames_load_func_info(frame, elf, frame->rel_pc);
+    }
+}
+
 int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd)
 {
     xcd_frame_t *frame;
@@ -258,6 +298,7 @@ int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd)
     char         offset_buf[64];
     char        *func;
     char         func_buf[512];
+    char        *so_name;
     int          r;
 
     if(0 != (r = xcc_util_write_str(log_fd, "backtrace:\n"))) return r;
@@ -266,6 +307,7 @@ int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd)
     {
         //name
         name = NULL;
+        so_name = NULL;
         if(NULL == frame->map)
         {
             name = "<unknown>";
@@ -287,6 +329,7 @@ int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd)
                     {
                         snprintf(name_buf, sizeof(name_buf), "%s!%s", frame->map->name, name_embedded);
                         name = name_buf;
+                        so_name = name_embedded;
                     }
                 }
             }
@@ -320,6 +363,9 @@ int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd)
 
         if(0 != (r = xcc_util_write_format(log_fd, "    #%02zu pc %0"XCC_UTIL_FMT_ADDR"  %s%s%s\n",
                                            frame->num, frame->rel_pc, name, offset, func))) return r;
+
+        xcd_bin_record_frame(frame->num, frame->pc, frame->rel_pc, xcd_maps_get_bin_index(self->maps, frame->map),
+                             frame->func_offset, frame->func_name, so_name);
     }
 
     if(0 != (r = xcc_util_write_str(log_fd, "\n"))) return r;
@@ -330,7 +376,7 @@ int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd)
 static int xcd_frames_record_buildid_line(xcd_frames_t *self, const char *name, xcd_map_t *map, int log_fd, int dump_elf_hash)
 {
     char    buf[1024];
-    size_t  offset, i;
+    size_t  offset, detail_offset, len, i;
     char   *error_from = "?";
 
     //pathname
@@ -349,7 +395,9 @@ static int xcd_frames_record_buildid_line(xcd_frames_t *self, const char *name,
     else
     {
         offset += (size_t)snprintf(buf + offset, sizeof(buf) - offset, "%s", "unknown");
+        build_id_len = 0;
     }
+    detail_offset = offset;
 
     //open file
     int fd;
@@ -430,6 +478,15 @@ static int xcd_frames_record_buildid_line(xcd_frames_t *self, const char *name,
 
  end:
     if(fd >= 0) close(fd);
+
+    //without the trailing line break
+    len = strlen(buf);
+    if(xcd_bin_is_opened() && len > detail_offset && '\n' == buf[len - 1])
+    {
+        buf[len - 1] = '\0';
+        xcd_bin_record_build_id(xcd_maps_get_bin_index(self->maps, map), build_id, build_id_len, buf + detail_offset);
+        buf[len - 1] = '\n';
+    }
     return xcc_util_write_str(log_fd, buf);
 }
 
@@ -487,10 +544,8 @@ int xcd_frames_record_buildid(xcd_frames_t *self, int log_fd, int dump_elf_hash,
 }
 
 static int xcd_frames_record_stack_segment(xcd_frames_t *self, int log_fd,
-                                           uintptr_t *sp, size_t words, int label)
+                                           uintptr_t *sp, uintptr_t *stack_data, size_t words, int label)
 {
-    uintptr_t  stack_data[XCD_FRAMES_STACK_WORDS];
-    size_t     bytes_read;
     size_t     i;
     char       line[512];
     size_t     line_len = 0;
@@ -502,10 +557,6 @@ static int xcd_frames_record_stack_segment(xcd_frames_t *self, int log_fd,
     size_t     func_offset;
     int        r;
 
-    //read remote data
-    bytes_read = xcd_util_ptrace_read(self->pid, *sp, stack_data, sizeof(uintptr_t) * words);
-    words = bytes_read / sizeof(uintptr_t);
-
     //print
     for(i = 0; i < words; i++)
     {
@@ -544,7 +595,7 @@ static int xcd_frames_record_stack_segment(xcd_frames_t *self, int log_fd,
                 
                 func_name = NULL;
                 func_offset = 0;
-                xcd_elf_get_function_info(elf, rel_pc, &func_name, &func_offset);
+                if(self->symbolize) xcd_elf_get_function_info(elf, rel_pc, &func_name, &func_offset);
 
                 if(NULL != func_name)
                 {
@@ -554,10 +605,10 @@ static int xcd_frames_record_stack_segment(xcd_frames_t *self, int log_fd,
                     else
                         line_len += (size_t)snprintf(line + line_len, sizeof(line) - line_len,
                                                      " (%s)", func_name);
+                    xcd_arena_heap_free(func_name);
                 }
             }
         }
-        if(NULL != func_name) free(func_name);
 
         snprintf(line + line_len, sizeof(line) - line_len, "\n");
         if(0 != (r = xcc_util_write_str(log_fd, line))) return r;
@@ -570,44 +621,51 @@ static int xcd_frames_record_stack_segment(xcd_frames_t *self, int log_fd,
 
 int xcd_frames_record_stack(xcd_frames_t *self, int log_fd)
 {
-    int          segment_recorded = 0;
-    xcd_frame_t *frame, *next_frame;
-    uintptr_t    sp = 0;
-    size_t       stack_size;
-    size_t       words;
-    int          r;
+    xcd_frames_stack_segment_t *segs = NULL;
+    xcd_util_remote_read_t     *reqs = NULL;
+    size_t                      segs_num = 0;
+    xcd_frame_t                *frame, *next_frame;
+    uintptr_t                   sp = 0;
+    size_t                      stack_size;
+    size_t                      words;
+    size_t                      i;
+    int                         r;
     
     if(0 != (r = xcc_util_write_str(log_fd, "stack:\n"))) return r;
 
+    //one segment for each frame, plus a few words before the first frame
+    if(NULL == (segs = xcd_arena_heap_malloc(sizeof(xcd_frames_stack_segment_t) * (self->frames_num + 1)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (reqs = xcd_arena_heap_calloc(self->frames_num + 1, sizeof(xcd_util_remote_read_t))))
+    {
+        r = XCC_ERRNO_NOMEM;
+        goto end;
+    }
+
+    //collect all the segments
     TAILQ_FOREACH(frame, &(self->frames), link)
     {
         if(0 == frame->sp)
         {
-            if(segment_recorded)
+            if(segs_num > 0)
                 break;
             else
                 continue;
         }
 
         //dump a few words before the first frame
-        if(!segment_recorded)
+        if(0 == segs_num)
         {
-            segment_recorded = 1;
-            sp = frame->sp - XCD_FRAMES_STACK_WORDS * sizeof(uintptr_t);
-            xcd_frames_record_stack_segment(self, log_fd, &sp, XCD_FRAMES_STACK_WORDS, -1);
-        }
-
-        if(sp != frame->sp)
-        {
-            if(0 != (r = xcc_util_write_str(log_fd, "         ........  ........\n"))) return r;
-            sp = frame->sp;
+            segs[segs_num].sp = frame->sp - XCD_FRAMES_STACK_WORDS * sizeof(uintptr_t);
+            segs[segs_num].words = XCD_FRAMES_STACK_WORDS;
+            segs[segs_num].label = -1;
+            segs_num++;
         }
 
         next_frame = TAILQ_NEXT(frame, link);
         if(NULL == next_frame || 0 == next_frame->sp || next_frame->sp < frame->sp)
         {
             //the last
-            xcd_frames_record_stack_segment(self, log_fd, &sp, XCD_FRAMES_STACK_WORDS, (int)frame->num);
+            words = XCD_FRAMES_STACK_WORDS;
         }
         else
         {
@@ -618,12 +676,37 @@ int xcd_frames_record_stack(xcd_frames_t *self, int log_fd)
                 words = 1;
             else if(words > XCD_FRAMES_STACK_WORDS)
                 words = XCD_FRAMES_STACK_WORDS;
-            xcd_frames_record_stack_segment(self, log_fd, &sp, words, (int)frame->num);
         }
-        
+        segs[segs_num].sp = frame->sp;
+        segs[segs_num].words = words;
+        segs[segs_num].label = (int)frame->num;
+        segs_num++;
     }
 
-    if(0 != (r = xcc_util_write_str(log_fd, "\n"))) return r;
+    //read remote data for all the segments at once
+    for(i = 0; i < segs_num; i++)
+    {
+        reqs[i].addr = segs[i].sp;
+        reqs[i].dst = segs[i].data;
+        reqs[i].len = sizeof(uintptr_t) * segs[i].words;
+    }
+    xcd_util_remote_readv_batch(self->pid, reqs, segs_num);
 
-    return 0;
+    //print
+    for(i = 0; i < segs_num; i++)
+    {
+        if(i > 0 && sp != segs[i].sp)
+        {
+            if(0 != (r = xcc_util_write_str(log_fd, "         ........  ........\n"))) goto end;
+        }
+        sp = segs[i].sp;
+        xcd_frames_record_stack_segment(self, log_fd, &sp, segs[i].data, reqs[i].bytes / sizeof(uintptr_t), segs[i].label);
+    }
+
+    r = xcc_util_write_str(log_fd, "\n");
+
+ end:
+    if(NULL != reqs) xcd_arena_heap_free(reqs);
+    xcd_arena_heap_free(segs);
+    return r;
 }
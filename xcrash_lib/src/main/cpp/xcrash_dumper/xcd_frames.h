@@ -36,8 +36,9 @@ extern "C" {
 
 typedef struct xcd_frames xcd_frames_t;
 
-int xcd_frames_create(xcd_frames_t **self, xcd_regs_t *regs, xcd_maps_t *maps, pid_t pid);
+int xcd_frames_create(xcd_frames_t **self, xcd_regs_t *regs, xcd_maps_t *maps, pid_t pid, int symbolize);
 void xcd_frames_destroy(xcd_frames_t **self);
+void xcd_frames_symbolize(xcd_frames_t *self);
 
 int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd);
 int xcd_frames_record_buildid(xcd_frames_t *self, int log_fd, int dump_elf_hash, uintptr_t fault_addr);
@@ -29,15 +29,18 @@
 #include "xcc_errno.h"
 #include "xcc_util.h"
 #include "xcd_map.h"
+#include "xcd_maps.h"
 #include "xcd_util.h"
 #include "xcd_log.h"
 
 int xcd_map_init(xcd_map_t *self, uintptr_t start, uintptr_t end, size_t offset,
-                 const char * flags, const char *name)
+                 const char * flags, uint64_t dev, uint64_t inode, char *name)
 {
     self->start  = start;
     self->end    = end;
     self->offset = offset;
+    self->dev    = dev;
+    self->inode  = inode;
     
     self->flags  = PROT_NONE;
     if(flags[0] == 'r') self->flags |= PROT_READ;
@@ -53,7 +56,7 @@ int xcd_map_init(xcd_map_t *self, uintptr_t start, uintptr_t end, size_t offset,
         if(0 == strncmp(name, "/dev/", 5) && 0 != strncmp(name + 5, "ashmem/", 7))
             self->flags |= XCD_MAP_PORT_DEVICE;
         
-        if(NULL == (self->name = strdup(name))) return XCC_ERRNO_NOMEM;
+        self->name = name; //owned by the caller
     }
 
     self->elf = NULL;
@@ -66,7 +69,6 @@ int xcd_map_init(xcd_map_t *self, uintptr_t start, uintptr_t end, size_t offset,
 
 void xcd_map_uninit(xcd_map_t *self)
 {
-    free(self->name);
     self->name = NULL;
 }
 
@@ -75,15 +77,27 @@ xcd_elf_t *xcd_map_get_elf(xcd_map_t *self, pid_t pid, void *maps_obj)
     xcd_memory_t *memory = NULL;
     xcd_elf_t    *elf = NULL;
 
+    xcd_maps_t   *maps = (xcd_maps_t *)maps_obj;
+
     if(NULL == self->elf && 0 == self->elf_loaded)
     {
         self->elf_loaded = 1;
+
+        //try the ELF shared by other maps of the same file
+        if(NULL != (elf = xcd_maps_get_cached_elf(maps, self)))
+        {
+            self->elf = elf;
+            return self->elf;
+        }
         
         if(0 != xcd_memory_create(&memory, self, pid, maps_obj)) return NULL;
 
         if(0 != xcd_elf_create(&elf, pid, memory)) return NULL;
         
         self->elf = elf;
+
+        //share the ELF with other maps of the same file
+        if(xcd_memory_is_file(memory)) xcd_maps_cache_elf(maps, self, elf);
     }
 
     return self->elf;
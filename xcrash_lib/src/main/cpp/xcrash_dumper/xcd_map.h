@@ -44,6 +44,8 @@ typedef struct xcd_map
     uintptr_t  end;
     size_t     offset;
     uint16_t   flags;
+    uint64_t   dev;
+    uint64_t   inode;
     char      *name;
 
     //ELF
@@ -55,7 +57,7 @@ typedef struct xcd_map
 #pragma clang diagnostic pop
 
 int xcd_map_init(xcd_map_t *self, uintptr_t start, uintptr_t end, size_t offset,
-                 const char * flags, const char *name);
+                 const char * flags, uint64_t dev, uint64_t inode, char *name);
 void xcd_map_uninit(xcd_map_t *self);
 
 xcd_elf_t *xcd_map_get_elf(xcd_map_t *self, pid_t pid, void *maps_obj);
@@ -26,6 +26,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include <sys/mman.h>
 #include "queue.h"
 #include "xcc_errno.h"
@@ -34,124 +36,352 @@
 #include "xcd_map.h"
 #include "xcd_util.h"
 #include "xcd_log.h"
+#include "xcd_arena.h"
+#include "xcd_bin.h"
 
 #define XCD_MAPS_ABORT_MSG_NAME    "[anon:abort message]"
 #define XCD_MAPS_ABORT_MSG_FLAGS   (PROT_READ | PROT_WRITE)
 #define XCD_MAPS_ABORT_MSG_MAGIC_1 0xb18e40886ac388f0ULL
 #define XCD_MAPS_ABORT_MSG_MAGIC_2 0xc6dfba755a1de0b5ULL
 
-typedef struct xcd_maps_item
+//ELF shared by all maps of the same file, covers [elf_start_offset, elf_end_offset) in the file
+typedef struct xcd_maps_elf
 {
-    xcd_map_t map;
-    TAILQ_ENTRY(xcd_maps_item,) link;
-} xcd_maps_item_t;
-typedef TAILQ_HEAD(xcd_maps_item_queue, xcd_maps_item,) xcd_maps_item_queue_t;
+    uint64_t   dev;
+    uint64_t   inode;
+    size_t     elf_start_offset;
+    size_t     elf_end_offset;
+    xcd_elf_t *elf;
+    TAILQ_ENTRY(xcd_maps_elf,) link;
+} xcd_maps_elf_t;
+typedef TAILQ_HEAD(xcd_maps_elf_queue, xcd_maps_elf,) xcd_maps_elf_queue_t;
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
 struct xcd_maps
 {
-    xcd_maps_item_queue_t maps;
+    char                 *data; //content of /proc/<PID>/maps, pathnames point into it
+    size_t                data_len;
+    xcd_map_t            *maps; //sorted by address
+    size_t                maps_num;
+    size_t                last_idx; //last hit of xcd_maps_find_map()
+    xcd_maps_elf_queue_t  elfs;
     pid_t                 pid;
 };
 #pragma clang diagnostic pop
 
-static int xcd_maps_parse_line(char *line, xcd_maps_item_t **mi)
+static char *xcd_maps_parse_hex(char *p, char *end, uint64_t *value)
 {
-    uintptr_t  start;
-    uintptr_t  end;
-    char       flags[5];
-    size_t     offset;
-    int        pos;
-    char      *name;
-
-    *mi = NULL;
-    
+    uint64_t v = 0;
+    char    *start = p;
+    uint8_t  c;
+
+    for(; p < end; p++)
+    {
+        c = (uint8_t)(*p);
+        if(c >= '0' && c <= '9')      c = (uint8_t)(c - '0');
+        else if(c >= 'a' && c <= 'f') c = (uint8_t)(c - 'a' + 10);
+        else if(c >= 'A' && c <= 'F') c = (uint8_t)(c - 'A' + 10);
+        else break;
+        v = (v << 4) | c;
+    }
+
+    *value = v;
+    return (p == start ? NULL : p);
+}
+
+static char *xcd_maps_parse_dec(char *p, char *end, uint64_t *value)
+{
+    uint64_t v = 0;
+    char    *start = p;
+
+    for(; p < end && *p >= '0' && *p <= '9'; p++)
+        v = v * 10 + (uint64_t)(*p - '0');
+
+    *value = v;
+    return (p == start ? NULL : p);
+}
+
+static char *xcd_maps_skip_spaces(char *p, char *end)
+{
+    while(p < end && (' ' == *p || '\t' == *p)) p++;
+    return p;
+}
+
+//line format: start-end flags offset dev_major:dev_minor inode [pathname]
+static int xcd_maps_parse_line(char *line, char *end, xcd_map_t *map, char **prev_name)
+{
+    uint64_t  start, stop, offset, dev_major, dev_minor, inode;
+    char     *p = line;
+    char     *flags;
+    char     *name;
+    char     *name_end;
+
     //scan
-    if(sscanf(line, "%"SCNxPTR"-%"SCNxPTR" %4s %"SCNxPTR" %*x:%*x %*d%n", &start, &end, flags, &offset, &pos) != 4) return 0;
-    name = xcc_util_trim(line + pos);
+    if(NULL == (p = xcd_maps_parse_hex(p, end, &start)) || p >= end || '-' != *p++) return XCC_ERRNO_FORMAT;
+    if(NULL == (p = xcd_maps_parse_hex(p, end, &stop)) || p >= end || ' ' != *p++) return XCC_ERRNO_FORMAT;
+    if(end - p < 5 || ' ' != p[4]) return XCC_ERRNO_FORMAT;
+    flags = p;
+    p += 5;
+    if(NULL == (p = xcd_maps_parse_hex(p, end, &offset)) || p >= end || ' ' != *p++) return XCC_ERRNO_FORMAT;
+    if(NULL == (p = xcd_maps_parse_hex(p, end, &dev_major)) || p >= end || ':' != *p++) return XCC_ERRNO_FORMAT;
+    if(NULL == (p = xcd_maps_parse_hex(p, end, &dev_minor)) || p >= end || ' ' != *p++) return XCC_ERRNO_FORMAT;
+    if(NULL == (p = xcd_maps_parse_dec(p, end, &inode))) return XCC_ERRNO_FORMAT;
+
+    //pathname (trimmed, terminated in place)
+    name = xcd_maps_skip_spaces(p, end);
+    name_end = end;
+    while(name_end > name && (' ' == *(name_end - 1) || '\t' == *(name_end - 1) || '\r' == *(name_end - 1))) name_end--;
+    *name_end = '\0';
+
+    //intern pathname (consecutive lines usually share the same pathname)
+    if(NULL != *prev_name && 0 == strcmp(*prev_name, name))
+        name = *prev_name;
+    else if('\0' != *name)
+        *prev_name = name;
     
-    //create map
-    if(NULL == (*mi = malloc(sizeof(xcd_maps_item_t)))) return XCC_ERRNO_NOMEM;
-    return xcd_map_init(&((*mi)->map), start, end, offset, flags, name);
+    //init map
+    return xcd_map_init(map, (uintptr_t)start, (uintptr_t)stop, (size_t)offset, flags,
+                        (dev_major << 32) | dev_minor, inode, name);
+}
+
+static int xcd_maps_read_file(const char *path, char **data, size_t *data_len)
+{
+    int      fd;
+    char    *buf = NULL, *new_buf;
+    size_t   buf_len = 64 * 1024;
+    size_t   len = 0;
+    ssize_t  n;
+    int      r;
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC)))) return XCC_ERRNO_SYS;
+
+    if(NULL == (buf = xcd_arena_heap_malloc(buf_len + 1)))
+    {
+        r = XCC_ERRNO_NOMEM;
+        goto err;
+    }
+
+    while(1)
+    {
+        if(len == buf_len)
+        {
+            buf_len *= 2;
+            if(NULL == (new_buf = xcd_arena_heap_realloc(buf, buf_len + 1)))
+            {
+                r = XCC_ERRNO_NOMEM;
+                goto err;
+            }
+            buf = new_buf;
+        }
+
+        if(0 > (n = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, buf + len, buf_len - len))))
+        {
+            r = XCC_ERRNO_SYS;
+            goto err;
+        }
+        if(0 == n) break; //EOF
+        len += (size_t)n;
+    }
+#pragma clang diagnostic pop
+
+    close(fd);
+    buf[len] = '\0';
+    *data = buf;
+    *data_len = len;
+    return 0;
+
+ err:
+    close(fd);
+    if(NULL != buf) xcd_arena_heap_free(buf);
+    return r;
+}
+
+static int xcd_maps_cmp(const void *a, const void *b)
+{
+    const xcd_map_t *ma = (const xcd_map_t *)a;
+    const xcd_map_t *mb = (const xcd_map_t *)b;
+
+    if(ma->start == mb->start) return 0;
+    else return (ma->start > mb->start ? 1 : -1);
 }
 
 int xcd_maps_create(xcd_maps_t **self, pid_t pid)
 {
-    char             buf[512];
-    FILE            *fp;
-    xcd_maps_item_t *mi;
+    char             path[64];
+    char            *line, *line_end, *data_end;
+    char            *prev_name = NULL;
+    size_t           lines_num = 0;
+    size_t           i;
     int              r;
 
-    if(NULL == (*self = malloc(sizeof(xcd_maps_t)))) return XCC_ERRNO_NOMEM;
-    TAILQ_INIT(&((*self)->maps));
+    if(NULL == (*self = xcd_arena_heap_malloc(sizeof(xcd_maps_t)))) return XCC_ERRNO_NOMEM;
+    (*self)->data = NULL;
+    (*self)->data_len = 0;
+    (*self)->maps = NULL;
+    (*self)->maps_num = 0;
+    (*self)->last_idx = 0;
+    TAILQ_INIT(&((*self)->elfs));
     (*self)->pid = pid;
 
-    snprintf(buf, sizeof(buf), "/proc/%d/maps", pid);
-    if(NULL == (fp = fopen(buf, "r"))) return XCC_ERRNO_SYS;
+    //read the whole file at once
+    snprintf(path, sizeof(path), "/proc/%d/maps", pid);
+    if(0 != (r = xcd_maps_read_file(path, &((*self)->data), &((*self)->data_len)))) return r;
+    data_end = (*self)->data + (*self)->data_len;
+
+    //allocate all maps in one block
+    for(line = (*self)->data; line < data_end; line = line_end + 1)
+    {
+        if(NULL == (line_end = memchr(line, '\n', (size_t)(data_end - line)))) line_end = data_end;
+        lines_num++;
+    }
+    if(0 == lines_num) return 0;
+    if(NULL == ((*self)->maps = xcd_arena_heap_calloc(lines_num, sizeof(xcd_map_t)))) return XCC_ERRNO_NOMEM;
+
+    //parse
+    for(line = (*self)->data; line < data_end; line = line_end + 1)
+    {
+        if(NULL == (line_end = memchr(line, '\n', (size_t)(data_end - line)))) line_end = data_end;
+        if(0 == xcd_maps_parse_line(line, line_end, &((*self)->maps[(*self)->maps_num]), &prev_name))
+            (*self)->maps_num++;
+    }
 
-    while(fgets(buf, sizeof(buf), fp))
+    //the kernel lists maps in ascending order, just in case
+    for(i = 1; i < (*self)->maps_num; i++)
     {
-        if(0 != (r = xcd_maps_parse_line(buf, &mi)))
+        if((*self)->maps[i].start < (*self)->maps[i - 1].start)
         {
-            fclose(fp);
-            return r;
+            qsort((*self)->maps, (*self)->maps_num, sizeof(xcd_map_t), xcd_maps_cmp);
+            break;
         }
-        
-        if(NULL != mi)
-            TAILQ_INSERT_TAIL(&((*self)->maps), mi, link);
     }
     
-    fclose(fp);
     return 0;
 }
 
 void xcd_maps_destroy(xcd_maps_t **self)
 {
-    xcd_maps_item_t *mi, *mi_tmp;
-    TAILQ_FOREACH_SAFE(mi, &((*self)->maps), link, mi_tmp)
+    size_t           i;
+    xcd_maps_elf_t  *me, *me_tmp;
+    for(i = 0; i < (*self)->maps_num; i++)
+        xcd_map_uninit(&((*self)->maps[i]));
+    xcd_arena_heap_free((*self)->maps);
+    xcd_arena_heap_free((*self)->data);
+    TAILQ_FOREACH_SAFE(me, &((*self)->elfs), link, me_tmp)
     {
-        TAILQ_REMOVE(&((*self)->maps), mi, link);
-        xcd_map_uninit(&(mi->map));
-        free(mi);
+        TAILQ_REMOVE(&((*self)->elfs), me, link);
     }
 
+    xcd_arena_heap_free(*self);
     *self = NULL;
 }
 
 xcd_map_t *xcd_maps_find_map(xcd_maps_t *self, uintptr_t pc)
 {
-    xcd_maps_item_t *mi;
+    xcd_map_t *map;
+    size_t     first = 0;
+    size_t     last = self->maps_num;
+    size_t     cur;
+
+    //check the last hit
+    if(self->last_idx < self->maps_num)
+    {
+        map = &(self->maps[self->last_idx]);
+        if(pc >= map->start && pc < map->end) return map;
+    }
+
+    //binary search for the first map which starts after pc
+    while(first < last)
+    {
+        cur = first + (last - first) / 2;
+        if(self->maps[cur].start <= pc)
+            first = cur + 1;
+        else
+            last = cur;
+    }
+    if(0 == last) return NULL;
+
+    map = &(self->maps[last - 1]);
+    if(pc >= map->end) return NULL;
+
+    self->last_idx = last - 1;
+    return map;
+}
+
+xcd_map_t *xcd_maps_get_prev_map(xcd_maps_t *self, xcd_map_t *cur_map)
+{
+    if(NULL == self || cur_map <= self->maps || cur_map >= self->maps + self->maps_num) return NULL;
 
-    TAILQ_FOREACH(mi, &(self->maps), link)
-        if(pc >= mi->map.start && pc < mi->map.end)
-            return &(mi->map);
+    return cur_map - 1;
+}
+
+//index in the binary tombstone's map table (0 means no map)
+size_t xcd_maps_get_bin_index(xcd_maps_t *self, xcd_map_t *map)
+{
+    if(NULL == map || map < self->maps || map >= self->maps + self->maps_num) return 0;
+
+    return (size_t)(map - self->maps) + 1;
+}
+
+xcd_elf_t *xcd_maps_get_cached_elf(xcd_maps_t *self, xcd_map_t *map)
+{
+    xcd_maps_elf_t *me;
+
+    if(0 == map->inode) return NULL;
+
+    TAILQ_FOREACH(me, &(self->elfs), link)
+    {
+        if(me->dev == map->dev && me->inode == map->inode &&
+           map->offset >= me->elf_start_offset && map->offset < me->elf_end_offset)
+        {
+            map->elf_offset = map->offset - me->elf_start_offset;
+            map->elf_start_offset = me->elf_start_offset;
+            return me->elf;
+        }
+    }
 
     return NULL;
 }
 
-xcd_map_t *xcd_maps_get_prev_map(xcd_maps_t *self, xcd_map_t *cur_map)
+void xcd_maps_cache_elf(xcd_maps_t *self, xcd_map_t *map, xcd_elf_t *elf)
 {
-    (void)self;
+    xcd_maps_elf_t *me;
+    size_t          max_size;
+    size_t          map_end_offset;
 
-    xcd_maps_item_t *cur_mi = (xcd_maps_item_t *)cur_map;
-    xcd_maps_item_t *prev_mi = TAILQ_PREV(cur_mi, xcd_maps_item_queue, link);
+    if(0 == map->inode) return;
 
-    return (NULL == prev_mi ? NULL : &(prev_mi->map));
+    if(NULL == (me = xcd_arena_alloc(sizeof(xcd_maps_elf_t)))) return;
+    me->dev = map->dev;
+    me->inode = map->inode;
+    me->elf_start_offset = map->elf_start_offset;
+    me->elf = elf;
+
+    //the ELF covers at least the current map
+    max_size = xcd_elf_get_max_size(xcd_elf_get_memory(elf));
+    map_end_offset = map->offset + (map->end - map->start);
+    if(__builtin_add_overflow(me->elf_start_offset, max_size, &(me->elf_end_offset)) || me->elf_end_offset < map_end_offset)
+        me->elf_end_offset = map_end_offset;
+
+    TAILQ_INSERT_TAIL(&(self->elfs), me, link);
 }
 
 uintptr_t xcd_maps_find_abort_msg(xcd_maps_t *self)
 {
-    xcd_maps_item_t *mi;
+    size_t           i;
+    xcd_map_t       *map;
     uintptr_t        p;
     uint64_t         magic;
 
-    TAILQ_FOREACH(mi, &(self->maps), link)
+    for(i = 0; i < self->maps_num; i++)
     {
-        if(NULL != mi->map.name && 0 == strcmp(mi->map.name, XCD_MAPS_ABORT_MSG_NAME) &&
-           XCD_MAPS_ABORT_MSG_FLAGS == mi->map.flags)
+        map = &(self->maps[i]);
+        if(NULL != map->name && 0 == strcmp(map->name, XCD_MAPS_ABORT_MSG_NAME) &&
+           XCD_MAPS_ABORT_MSG_FLAGS == map->flags)
         {
-            p = mi->map.start;
+            p = map->start;
             if(0 != xcd_util_ptrace_read_fully(self->pid, p, &magic, sizeof(uint64_t))) continue;
             if(XCD_MAPS_ABORT_MSG_MAGIC_1 != magic) continue;
 
@@ -159,7 +389,7 @@ uintptr_t xcd_maps_find_abort_msg(xcd_maps_t *self)
             if(0 != xcd_util_ptrace_read_fully(self->pid, p, &magic, sizeof(uint64_t))) continue;
             if(XCD_MAPS_ABORT_MSG_MAGIC_2 != magic) continue;
 
-            return mi->map.start;
+            return map->start;
         }
     }
 
@@ -168,21 +398,23 @@ uintptr_t xcd_maps_find_abort_msg(xcd_maps_t *self)
 
 uintptr_t xcd_maps_find_pc(xcd_maps_t *self, const char *pathname, const char *symbol)
 {
-    xcd_maps_item_t *mi;
+    size_t           i;
+    xcd_map_t       *map;
     xcd_elf_t       *elf;
     uintptr_t        addr = 0;
 
-    TAILQ_FOREACH(mi, &(self->maps), link)
+    for(i = 0; i < self->maps_num; i++)
     {
-        if(NULL != mi->map.name && 0 == strcmp(mi->map.name, pathname))
+        map = &(self->maps[i]);
+        if(NULL != map->name && 0 == strcmp(map->name, pathname))
         {
             //get ELF
-            if(NULL == (elf = xcd_map_get_elf(&(mi->map), self->pid, (void *)self))) return 0;
+            if(NULL == (elf = xcd_map_get_elf(map, self->pid, (void *)self))) return 0;
 
             //get rel addr (offset)
             if(0 != xcd_elf_get_symbol_addr(elf, symbol, &addr)) return 0;
 
-            return xcd_map_get_abs_pc(&(mi->map), addr, self->pid, (void *)self);
+            return xcd_map_get_abs_pc(map, addr, self->pid, (void *)self);
         }
     }
 
@@ -192,7 +424,8 @@ uintptr_t xcd_maps_find_pc(xcd_maps_t *self, const char *pathname, const char *s
 int xcd_maps_record(xcd_maps_t *self, int log_fd)
 {
     int              r;
-    xcd_maps_item_t *mi;
+    size_t           i;
+    xcd_map_t       *map;
     uintptr_t        size;
     uintptr_t        total_size = 0;
     size_t           max_size = 0;
@@ -205,11 +438,12 @@ int xcd_maps_record(xcd_maps_t *self, int log_fd)
     char            *prev_name = NULL;
 
     //get width of size and offset columns
-    TAILQ_FOREACH(mi, &(self->maps), link)
+    for(i = 0; i < self->maps_num; i++)
     {
-        size = mi->map.end - mi->map.start;
+        map = &(self->maps[i]);
+        size = map->end - map->start;
         if(size > max_size) max_size = size;
-        if(mi->map.offset > max_offset) max_offset = mi->map.offset;
+        if(map->offset > max_offset) max_offset = map->offset;
     }
     while(0 != max_size)
     {
@@ -226,23 +460,25 @@ int xcd_maps_record(xcd_maps_t *self, int log_fd)
 
     //dump
     if(0 != (r = xcc_util_write_str(log_fd, "memory map:\n"))) return r;
-    TAILQ_FOREACH(mi, &(self->maps), link)
+    for(i = 0; i < self->maps_num; i++)
     {
+        map = &(self->maps[i]);
+
         //get load_bias
-        if(NULL != mi->map.elf && 0 != (load_bias = xcd_elf_get_load_bias(mi->map.elf)))
+        if(NULL != map->elf && 0 != (load_bias = xcd_elf_get_load_bias(map->elf)))
             snprintf(load_bias_buf, sizeof(load_bias_buf), " (load bias 0x%"PRIxPTR")", load_bias);
         else
             load_bias_buf[0] = '\0';
 
         //fix name and load_bias
-        if(NULL != mi->map.name)
+        if(NULL != map->name)
         {
             if(NULL == prev_name)
-                name = mi->map.name;
-            else if(0 == strcmp(prev_name, mi->map.name) && '\0' == load_bias_buf[0])
+                name = map->name;
+            else if(0 == strcmp(prev_name, map->name) && '\0' == load_bias_buf[0])
                 name = ">"; //same as prev line
             else
-                name = mi->map.name;
+                name = map->name;
         }
         else
         {
@@ -250,19 +486,19 @@ int xcd_maps_record(xcd_maps_t *self, int log_fd)
         }
 
         //save prev name
-        prev_name = mi->map.name;
+        prev_name = map->name;
 
         //update total size
-        size = mi->map.end - mi->map.start;
+        size = map->end - map->start;
         total_size += size;
 
         if(0 != (r = xcc_util_write_format(log_fd,
                                            "    %0"XCC_UTIL_FMT_ADDR"-%0"XCC_UTIL_FMT_ADDR" %c%c%c %*"PRIxPTR" %*"PRIxPTR" %s%s\n",
-                                           mi->map.start, mi->map.end,
-                                           mi->map.flags & PROT_READ ? 'r' : '-',
-                                           mi->map.flags & PROT_WRITE ? 'w' : '-',
-                                           mi->map.flags & PROT_EXEC ? 'x' : '-',
-                                           width_offset, mi->map.offset,
+                                           map->start, map->end,
+                                           map->flags & PROT_READ ? 'r' : '-',
+                                           map->flags & PROT_WRITE ? 'w' : '-',
+                                           map->flags & PROT_EXEC ? 'x' : '-',
+                                           width_offset, map->offset,
                                            width_size, size,
                                            name, load_bias_buf))) return r;
     }
@@ -271,3 +507,58 @@ int xcd_maps_record(xcd_maps_t *self, int log_fd)
 
     return 0;
 }
+
+void xcd_maps_record_bin(xcd_maps_t *self)
+{
+    size_t        i;
+    xcd_map_t    *map;
+    char         *prev_name = NULL;
+    unsigned int  flags;
+
+    if(!xcd_bin_is_opened()) return;
+
+    for(i = 0; i < self->maps_num; i++)
+    {
+        map = &(self->maps[i]);
+
+        flags = 0;
+        if(map->flags & PROT_READ) flags |= XCD_BIN_MAP_FLAG_READ;
+        if(map->flags & PROT_WRITE) flags |= XCD_BIN_MAP_FLAG_WRITE;
+        if(map->flags & PROT_EXEC) flags |= XCD_BIN_MAP_FLAG_EXEC;
+        if(NULL != prev_name && NULL != map->name && 0 == strcmp(prev_name, map->name)) flags |= XCD_BIN_MAP_FLAG_SAME_NAME;
+        prev_name = map->name;
+
+        //the ELFs are not loaded yet, see xcd_maps_record_bin_load_bias()
+        xcd_bin_record_map(map->start, map->end, map->offset, flags, map->elf_start_offset, 0, map->name);
+    }
+}
+
+//the read-only mappings can still be read after the remote threads have been resumed
+void xcd_maps_add_readonly(xcd_maps_t *self)
+{
+    size_t     i;
+    xcd_map_t *map;
+
+    for(i = 0; i < self->maps_num; i++)
+    {
+        map = &(self->maps[i]);
+        if(!(map->flags & PROT_READ) || (map->flags & PROT_WRITE) || (map->flags & XCD_MAP_PORT_DEVICE)) continue;
+        if(0 != xcd_util_add_readonly(map->start, map->end)) break;
+    }
+}
+
+void xcd_maps_record_bin_load_bias(xcd_maps_t *self)
+{
+    size_t     i;
+    xcd_map_t *map;
+    uintptr_t  load_bias;
+
+    if(!xcd_bin_is_opened()) return;
+
+    for(i = 0; i < self->maps_num; i++)
+    {
+        map = &(self->maps[i]);
+        if(NULL != map->elf && 0 != (load_bias = xcd_elf_get_load_bias(map->elf)))
+            xcd_bin_record_load_bias(i + 1, load_bias);
+    }
+}
@@ -41,12 +41,21 @@ void xcd_maps_destroy(xcd_maps_t **self);
 xcd_map_t *xcd_maps_find_map(xcd_maps_t *self, uintptr_t pc);
 xcd_map_t *xcd_maps_get_prev_map(xcd_maps_t *self, xcd_map_t *cur_map);
 
+xcd_elf_t *xcd_maps_get_cached_elf(xcd_maps_t *self, xcd_map_t *map);
+void xcd_maps_cache_elf(xcd_maps_t *self, xcd_map_t *map, xcd_elf_t *elf);
+
 uintptr_t xcd_maps_find_abort_msg(xcd_maps_t *self);
 
 uintptr_t xcd_maps_find_pc(xcd_maps_t *self, const char *pathname, const char *symbol);
 
 int xcd_maps_record(xcd_maps_t *self, int log_fd);
 
+size_t xcd_maps_get_bin_index(xcd_maps_t *self, xcd_map_t *map);
+void xcd_maps_record_bin(xcd_maps_t *self);
+void xcd_maps_record_bin_load_bias(xcd_maps_t *self);
+
+void xcd_maps_add_readonly(xcd_maps_t *self);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,13 +24,16 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <sys/mman.h>
 #include "xcc_errno.h"
+#include "xcc_util.h"
 #include "xcd_map.h"
 #include "xcd_memory.h"
 #include "xcd_memory_file.h"
 #include "xcd_memory_buf.h"
 #include "xcd_memory_remote.h"
+#include "xcd_arena.h"
 
 extern const xcd_memory_handlers_t xcd_memory_buf_handlers;
 extern const xcd_memory_handlers_t xcd_memory_file_handlers;
@@ -50,7 +53,7 @@ int xcd_memory_create(xcd_memory_t **self, void *map_obj, pid_t pid, void *maps_
     if(map->end <= map->start) return XCC_ERRNO_INVAL;
     if(map->flags & XCD_MAP_PORT_DEVICE) return XCC_ERRNO_DEV;
     
-    if(NULL == (*self = malloc(sizeof(xcd_memory_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (*self = xcd_arena_heap_malloc(sizeof(xcd_memory_t)))) return XCC_ERRNO_NOMEM;
     
     //try memory from file
     (*self)->handlers = &xcd_memory_file_handlers;
@@ -63,28 +66,33 @@ int xcd_memory_create(xcd_memory_t **self, void *map_obj, pid_t pid, void *maps_
     if(0 == xcd_memory_remote_create(&((*self)->obj), map, pid)) return 0;
     (void)pid;
 
-    free(*self);
+    xcd_arena_heap_free(*self);
     return XCC_ERRNO_MEM;
 }
 
 //for ELF header info unzipped from .gnu_debugdata in the local memory
 int xcd_memory_create_from_buf(xcd_memory_t **self, uint8_t *buf, size_t len)
 {
-    if(NULL == (*self = malloc(sizeof(xcd_memory_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (*self = xcd_arena_heap_malloc(sizeof(xcd_memory_t)))) return XCC_ERRNO_NOMEM;
     (*self)->handlers = &xcd_memory_buf_handlers;
     if(0 == xcd_memory_buf_create(&((*self)->obj), buf, len)) return 0;
 
-    free(*self);
+    xcd_arena_heap_free(*self);
     return XCC_ERRNO_MEM;
 }
 
 void xcd_memory_destroy(xcd_memory_t **self)
 {
     (*self)->handlers->destroy(&((*self)->obj));
-    free(*self);
+    xcd_arena_heap_free(*self);
     *self = NULL;
 }
 
+int xcd_memory_is_file(xcd_memory_t *self)
+{
+    return (&xcd_memory_file_handlers == self->handlers ? 1 : 0);
+}
+
 size_t xcd_memory_read(xcd_memory_t *self, uintptr_t addr, void *dst, size_t size)
 {
     return self->handlers->read(self->obj, addr, dst, size);
@@ -96,23 +104,50 @@ int xcd_memory_read_fully(xcd_memory_t *self, uintptr_t addr, void* dst, size_t
     return rc == size ? 0 : XCC_ERRNO_MISSING;
 }
 
+//get a direct pointer to the data, return the number of bytes available (0 if not supported)
+size_t xcd_memory_peek(xcd_memory_t *self, uintptr_t addr, const void **ptr)
+{
+    if(NULL == self->handlers->peek) return 0;
+    return self->handlers->peek(self->obj, addr, ptr);
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
 int xcd_memory_read_string(xcd_memory_t *self, uintptr_t addr, char *dst, size_t size, size_t max_read)
 {
-    char   value;
+    size_t page_size = (size_t)getpagesize();
+    size_t limit = XCC_UTIL_MIN(size, max_read);
     size_t i = 0;
-    int    r;
+    size_t chunk;
+    size_t rc;
     
-    while(i < size && i < max_read)
+    while(i < limit)
     {
-        if(0 != (r = xcd_memory_read_fully(self, addr, &value, sizeof(value)))) return r;
-        dst[i] = value;
-        if('\0' == value) return 0;
-        addr++;
-        i++;
+        //read in chunks, but never cross a page boundary (avoid reading beyond the end of mapping)
+        chunk = page_size - ((addr + i) & (page_size - 1));
+        chunk = XCC_UTIL_MIN(chunk, limit - i);
+
+        if(0 == (rc = xcd_memory_read(self, addr + i, dst + i, chunk))) return XCC_ERRNO_MISSING;
+        if(NULL != memchr(dst + i, '\0', rc)) return 0;
+        i += rc;
     }
     return XCC_ERRNO_NOSPACE;
 }
 
+//get a direct pointer to the string in local memory, return NULL if not supported or not terminated
+const char *xcd_memory_get_string(xcd_memory_t *self, uintptr_t addr, size_t max_read)
+{
+    const void *ptr = NULL;
+    size_t      size;
+
+    if(0 == (size = xcd_memory_peek(self, addr, &ptr))) return NULL;
+    size = XCC_UTIL_MIN(size, max_read);
+    if(NULL == memchr(ptr, '\0', size)) return NULL;
+
+    return (const char *)ptr;
+}
+#pragma clang diagnostic pop
+
 int xcd_memory_read_uleb128(xcd_memory_t *self, uintptr_t addr, uint64_t *dst, size_t *size)
 {
     uint64_t cur_value = 0;
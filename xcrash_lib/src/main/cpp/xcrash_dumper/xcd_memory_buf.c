@@ -33,6 +33,7 @@
 #include "xcd_memory.h"
 #include "xcd_memory_buf.h"
 #include "xcd_util.h"
+#include "xcd_arena.h"
 
 struct xcd_memory_buf
 {
@@ -44,7 +45,7 @@ int xcd_memory_buf_create(void **obj, uint8_t *buf, size_t len)
 {
     xcd_memory_buf_t **self = (xcd_memory_buf_t **)obj;
     
-    if(NULL == (*self = malloc(sizeof(xcd_memory_buf_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (*self = xcd_arena_heap_malloc(sizeof(xcd_memory_buf_t)))) return XCC_ERRNO_NOMEM;
     (*self)->buf = buf;
     (*self)->len = len;
 
@@ -55,8 +56,8 @@ void xcd_memory_buf_destroy(void **obj)
 {
     xcd_memory_buf_t **self = (xcd_memory_buf_t **)obj;
 
-    free((*self)->buf);
-    free(*self);
+    xcd_arena_heap_free((*self)->buf);
+    xcd_arena_heap_free(*self);
     *self = NULL;
 }
 
@@ -75,10 +76,21 @@ size_t xcd_memory_buf_read(void *obj, uintptr_t addr, void *dst, size_t size)
     return read_length;
 }
 
+size_t xcd_memory_buf_peek(void *obj, uintptr_t addr, const void **ptr)
+{
+    xcd_memory_buf_t *self = (xcd_memory_buf_t *)obj;
+
+    if((size_t)addr >= self->len) return 0;
+
+    *ptr = self->buf + addr;
+    return self->len - (size_t)addr;
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wmissing-variable-declarations"
 const xcd_memory_handlers_t xcd_memory_buf_handlers = {
     xcd_memory_buf_destroy,
-    xcd_memory_buf_read
+    xcd_memory_buf_read,
+    xcd_memory_buf_peek
 };
 #pragma clang diagnostic pop
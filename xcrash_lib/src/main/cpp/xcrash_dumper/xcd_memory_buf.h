@@ -37,6 +37,7 @@ typedef struct xcd_memory_buf xcd_memory_buf_t;
 int xcd_memory_buf_create(void **obj, uint8_t *buf, size_t len);
 void xcd_memory_buf_destroy(void **obj);
 size_t xcd_memory_buf_read(void *obj, uintptr_t addr, void *dst, size_t size);
+size_t xcd_memory_buf_peek(void *obj, uintptr_t addr, const void **ptr);
 
 #ifdef __cplusplus
 }
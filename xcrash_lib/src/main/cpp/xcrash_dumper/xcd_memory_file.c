@@ -36,21 +36,47 @@
 #include "xcd_memory.h"
 #include "xcd_memory_file.h"
 #include "xcd_util.h"
+#include "xcd_arena.h"
+
+//files bigger than this are read by pread() through a small LRU of blocks instead of mmap()
+#define XCD_MEMORY_FILE_MMAP_MAX    (32 * 1024 * 1024)
+#define XCD_MEMORY_FILE_BLOCK_SIZE  (16 * 1024)
+#define XCD_MEMORY_FILE_BLOCK_NUM   32
+
+//posix_fadvise() is only available since API level 21
+extern __attribute((weak)) int posix_fadvise(int, off_t, off_t, int);
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    off_t    offset; //aligned file offset
+    size_t   len;    //0 means empty
+    size_t   tick;   //last used
+    uint8_t *data;
+} xcd_memory_file_block_t;
+
 struct xcd_memory_file
 {
-    xcd_memory_t *base;
-    int           fd;
-    uint8_t      *data;
-    size_t        offset;
-    size_t        size;
+    xcd_memory_t            *base;
+    int                      fd;
+    uint8_t                 *data;
+    size_t                   offset;
+    size_t                   size;
+
+    //pread mode
+    int                      pread_mode;
+    off_t                    pread_offset; //file offset of address 0
+    xcd_memory_file_block_t *blocks;
+    uint8_t                 *blocks_data;
+    size_t                   blocks_tick;
 };
 #pragma clang diagnostic pop
 
 static void xcd_memory_file_uninit(xcd_memory_file_t *self)
 {
+    size_t i;
+    
     if(NULL != self->data)
     {
         munmap(self->data - self->offset, self->size + self->offset);
@@ -58,6 +84,102 @@ static void xcd_memory_file_uninit(xcd_memory_file_t *self)
         self->offset = 0;
         self->size = 0;
     }
+
+    if(self->pread_mode)
+    {
+        //the blocks are kept for reuse, but their contents are dropped
+        if(NULL != self->blocks)
+            for(i = 0; i < XCD_MEMORY_FILE_BLOCK_NUM; i++)
+                self->blocks[i].len = 0;
+        self->pread_mode = 0;
+        self->pread_offset = 0;
+        self->offset = 0;
+        self->size = 0;
+    }
+}
+
+static int xcd_memory_file_init_pread(xcd_memory_file_t *self, size_t offset)
+{
+    size_t i;
+    
+    if(NULL == self->blocks)
+    {
+        if(NULL == (self->blocks = xcd_arena_heap_calloc(XCD_MEMORY_FILE_BLOCK_NUM, sizeof(xcd_memory_file_block_t)))) return XCC_ERRNO_NOMEM;
+        if(NULL == (self->blocks_data = xcd_arena_heap_malloc(XCD_MEMORY_FILE_BLOCK_NUM * XCD_MEMORY_FILE_BLOCK_SIZE)))
+        {
+            xcd_arena_heap_free(self->blocks);
+            self->blocks = NULL;
+            return XCC_ERRNO_NOMEM;
+        }
+        for(i = 0; i < XCD_MEMORY_FILE_BLOCK_NUM; i++)
+            self->blocks[i].data = self->blocks_data + i * XCD_MEMORY_FILE_BLOCK_SIZE;
+    }
+    
+    self->pread_mode = 1;
+    self->pread_offset = (off_t)offset;
+
+    //reads of symbols, unwind tables and strings are scattered all over the file
+    if(NULL != posix_fadvise)
+        posix_fadvise(self->fd, self->pread_offset, (off_t)(self->size), POSIX_FADV_RANDOM);
+    return 0;
+}
+
+static xcd_memory_file_block_t *xcd_memory_file_get_block(xcd_memory_file_t *self, off_t offset)
+{
+    xcd_memory_file_block_t *block, *victim = NULL;
+    ssize_t                  rc;
+    size_t                   i;
+
+    self->blocks_tick++;
+    
+    for(i = 0; i < XCD_MEMORY_FILE_BLOCK_NUM; i++)
+    {
+        block = &(self->blocks[i]);
+        if(block->len > 0 && block->offset == offset)
+        {
+            block->tick = self->blocks_tick;
+            return block;
+        }
+        if(NULL == victim || 0 == block->len || (0 != victim->len && block->tick < victim->tick))
+            victim = block;
+    }
+    
+    //load into the least recently used (or empty) block
+    victim->len = 0;
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+    rc = XCC_UTIL_TEMP_FAILURE_RETRY(pread(self->fd, victim->data, XCD_MEMORY_FILE_BLOCK_SIZE, offset));
+#pragma clang diagnostic pop
+    if(rc <= 0) return NULL;
+    victim->offset = offset;
+    victim->len = (size_t)rc;
+    victim->tick = self->blocks_tick;
+    return victim;
+}
+
+static size_t xcd_memory_file_pread(xcd_memory_file_t *self, uintptr_t addr, void *dst, size_t size)
+{
+    xcd_memory_file_block_t *block;
+    off_t                    offset, block_offset;
+    size_t                   block_skip, len, total = 0;
+
+    while(total < size)
+    {
+        offset = self->pread_offset + (off_t)(addr + total);
+        block_offset = offset & ~((off_t)XCD_MEMORY_FILE_BLOCK_SIZE - 1);
+        block_skip = (size_t)(offset - block_offset);
+        
+        if(NULL == (block = xcd_memory_file_get_block(self, block_offset))) break;
+        if(block->len <= block_skip) break; //EOF
+
+        len = block->len - block_skip;
+        if(len > size - total) len = size - total;
+        memcpy((uint8_t *)dst + total, block->data + block_skip, len);
+        total += len;
+
+        if(block->len < XCD_MEMORY_FILE_BLOCK_SIZE) break; //EOF
+    }
+    return total;
 }
 
 static int xcd_memory_file_init(xcd_memory_file_t *self, size_t size, size_t offset, uint64_t file_size)
@@ -76,6 +198,14 @@ static int xcd_memory_file_init(xcd_memory_file_t *self, size_t size, size_t off
     if(!__builtin_add_overflow(size, self->offset, &max_size) && max_size < self->size)
         self->size = max_size;
 
+    //avoid huge VMA and page-fault-driven random I/O for big files (split APKs, oat files, ...)
+    if(self->size > XCD_MEMORY_FILE_MMAP_MAX)
+    {
+        self->size -= self->offset;
+        self->offset = 0;
+        return xcd_memory_file_init_pread(self, offset);
+    }
+
     void* map = mmap(NULL, self->size, PROT_READ, MAP_PRIVATE, self->fd, (off_t)aligned_offset);
     if(map == MAP_FAILED) return XCC_ERRNO_SYS;
 
@@ -98,12 +228,17 @@ int xcd_memory_file_create(void **obj, xcd_memory_t *base, xcd_map_t *map, xcd_m
 
     if(NULL == map->name || 0 == strlen(map->name)) return XCC_ERRNO_INVAL;
     
-    if(NULL == (*self = malloc(sizeof(xcd_memory_file_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (*self = xcd_arena_heap_malloc(sizeof(xcd_memory_file_t)))) return XCC_ERRNO_NOMEM;
     (*self)->base = base;
     (*self)->fd = -1;
     (*self)->data = NULL;
     (*self)->offset = 0;
     (*self)->size = 0;
+    (*self)->pread_mode = 0;
+    (*self)->pread_offset = 0;
+    (*self)->blocks = NULL;
+    (*self)->blocks_data = NULL;
+    (*self)->blocks_tick = 0;
 
     //open file
 #pragma clang diagnostic push
@@ -226,7 +361,9 @@ int xcd_memory_file_create(void **obj, xcd_memory_t *base, xcd_map_t *map, xcd_m
     map->elf_start_offset = 0;
     xcd_memory_file_uninit(*self);
     if((*self)->fd < 0) close((*self)->fd);
-    free(*self);
+    if(NULL != (*self)->blocks_data) xcd_arena_heap_free((*self)->blocks_data);
+    if(NULL != (*self)->blocks) xcd_arena_heap_free((*self)->blocks);
+    xcd_arena_heap_free(*self);
     *self = NULL;
     return r;
 }
@@ -237,7 +374,9 @@ void xcd_memory_file_destroy(void **obj)
     
     xcd_memory_file_uninit(*self);
     close((*self)->fd);
-    free(*self);
+    if(NULL != (*self)->blocks_data) xcd_arena_heap_free((*self)->blocks_data);
+    if(NULL != (*self)->blocks) xcd_arena_heap_free((*self)->blocks);
+    xcd_arena_heap_free(*self);
     *self = NULL;
 }
 
@@ -248,6 +387,8 @@ size_t xcd_memory_file_read(void *obj, uintptr_t addr, void *dst, size_t size)
     if(addr >= self->size) return 0;
 
     size_t bytes_left = self->size - (size_t)addr;
+    if(self->pread_mode) return xcd_memory_file_pread(self, addr, dst, size < bytes_left ? size : bytes_left);
+
     uint8_t *actual_base = self->data + addr;
 
 #pragma clang diagnostic push
@@ -259,10 +400,22 @@ size_t xcd_memory_file_read(void *obj, uintptr_t addr, void *dst, size_t size)
     return actual_len;
 }
 
+size_t xcd_memory_file_peek(void *obj, uintptr_t addr, const void **ptr)
+{
+    xcd_memory_file_t *self = (xcd_memory_file_t *)obj;
+
+    if(addr >= self->size) return 0;
+    if(self->pread_mode) return 0; //no direct pointer
+
+    *ptr = self->data + addr;
+    return self->size - (size_t)addr;
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wmissing-variable-declarations"
 const xcd_memory_handlers_t xcd_memory_file_handlers = {
     xcd_memory_file_destroy,
-    xcd_memory_file_read
+    xcd_memory_file_read,
+    xcd_memory_file_peek
 };
 #pragma clang diagnostic pop
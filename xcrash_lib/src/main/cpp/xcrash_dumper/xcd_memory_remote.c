@@ -34,6 +34,11 @@
 #include "xcd_memory_remote.h"
 #include "xcd_util.h"
 #include "xcd_log.h"
+#include "xcd_arena.h"
+
+//page cache (direct-mapped), the target process is stopped during the dump, so the cache never expires
+#define XCD_MEMORY_REMOTE_CACHE_PAGE_SIZE 4096
+#define XCD_MEMORY_REMOTE_CACHE_PAGES     16
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
@@ -42,6 +47,11 @@ struct xcd_memory_remote
     pid_t     pid;
     uintptr_t start;
     size_t    length;
+
+    //page cache (allocated on first use)
+    uint8_t  *cache;
+    uintptr_t cache_addrs[XCD_MEMORY_REMOTE_CACHE_PAGES];
+    size_t    cache_lens[XCD_MEMORY_REMOTE_CACHE_PAGES]; //0 means empty
 };
 #pragma clang diagnostic pop
 
@@ -49,10 +59,12 @@ int xcd_memory_remote_create(void **obj, xcd_map_t *map, pid_t pid)
 {
     xcd_memory_remote_t **self = (xcd_memory_remote_t **)obj;
     
-    if(NULL == (*self = malloc(sizeof(xcd_memory_remote_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (*self = xcd_arena_heap_malloc(sizeof(xcd_memory_remote_t)))) return XCC_ERRNO_NOMEM;
     (*self)->pid = pid;
     (*self)->start = map->start;
     (*self)->length = (size_t)(map->end - map->start);
+    (*self)->cache = NULL;
+    memset((*self)->cache_lens, 0, sizeof((*self)->cache_lens));
 
     return 0;
 }
@@ -61,10 +73,61 @@ void xcd_memory_remote_destroy(void **obj)
 {
     xcd_memory_remote_t **self = (xcd_memory_remote_t **)obj;
     
-    free(*self);
+    if(NULL != (*self)->cache) xcd_arena_heap_free((*self)->cache);
+    xcd_arena_heap_free(*self);
     *self = NULL;
 }
 
+static size_t xcd_memory_remote_read_cached(xcd_memory_remote_t *self, uintptr_t addr, void *dst, size_t size)
+{
+    uintptr_t page_addr;
+    size_t    page_offset;
+    size_t    idx;
+    size_t    len;
+    size_t    done = 0;
+    uint8_t  *page;
+
+    //allocate cache
+    if(NULL == self->cache && NULL == (self->cache = xcd_arena_heap_malloc(XCD_MEMORY_REMOTE_CACHE_PAGE_SIZE * XCD_MEMORY_REMOTE_CACHE_PAGES)))
+        return xcd_util_ptrace_read(self->pid, addr, dst, size);
+
+    while(done < size)
+    {
+        page_addr = (addr + done) & ~((uintptr_t)XCD_MEMORY_REMOTE_CACHE_PAGE_SIZE - 1);
+        page_offset = (size_t)(addr + done - page_addr);
+        idx = (size_t)(page_addr / XCD_MEMORY_REMOTE_CACHE_PAGE_SIZE) % XCD_MEMORY_REMOTE_CACHE_PAGES;
+        page = self->cache + idx * XCD_MEMORY_REMOTE_CACHE_PAGE_SIZE;
+
+        //fill the page (only the part inside the map)
+        if(0 == self->cache_lens[idx] || page_addr != self->cache_addrs[idx])
+        {
+            len = XCD_MEMORY_REMOTE_CACHE_PAGE_SIZE;
+            if(page_addr < self->start) len = 0; //the map is not page-aligned, should not happen
+            else if(page_addr - self->start + len > self->length) len = self->length - (size_t)(page_addr - self->start);
+
+            self->cache_addrs[idx] = page_addr;
+            self->cache_lens[idx] = (0 == len ? 0 : xcd_util_ptrace_read(self->pid, page_addr, page, len));
+            if(0 == self->cache_lens[idx])
+            {
+                //fall back to read directly
+                return done + xcd_util_ptrace_read(self->pid, addr + done, (uint8_t *)dst + done, size - done);
+            }
+        }
+        if(page_offset >= self->cache_lens[idx]) break;
+
+        //copy from the page
+        len = self->cache_lens[idx] - page_offset;
+        if(len > size - done) len = size - done;
+        memcpy((uint8_t *)dst + done, page + page_offset, len);
+        done += len;
+
+        //the page is incomplete
+        if(page_offset + len < XCD_MEMORY_REMOTE_CACHE_PAGE_SIZE && done < size) break;
+    }
+
+    return done;
+}
+
 size_t xcd_memory_remote_read(void *obj, uintptr_t addr, void *dst, size_t size)
 {
     xcd_memory_remote_t *self = (xcd_memory_remote_t *)obj;
@@ -78,14 +141,19 @@ size_t xcd_memory_remote_read(void *obj, uintptr_t addr, void *dst, size_t size)
     
     uint64_t read_addr;
     if(__builtin_add_overflow(self->start, addr, &read_addr)) return 0;
-    
-    return xcd_util_ptrace_read(self->pid, (uintptr_t)read_addr, dst, read_length);
+
+    //read large blocks directly
+    if(read_length > XCD_MEMORY_REMOTE_CACHE_PAGE_SIZE)
+        return xcd_util_ptrace_read(self->pid, (uintptr_t)read_addr, dst, read_length);
+
+    return xcd_memory_remote_read_cached(self, (uintptr_t)read_addr, dst, read_length);
 }
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wmissing-variable-declarations"
 const xcd_memory_handlers_t xcd_memory_remote_handlers = {
     xcd_memory_remote_destroy,
-    xcd_memory_remote_read
+    xcd_memory_remote_read,
+    NULL
 };
 #pragma clang diagnostic pop
@@ -33,6 +33,7 @@
 #include <string.h>
 #include <regex.h>
 #include <ctype.h>
+#include <errno.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -51,12 +52,18 @@
 #include "xcd_regs.h"
 #include "xcd_util.h"
 #include "xcd_sys.h"
+#include "xcd_arena.h"
+#include "xcd_bin.h"
 
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
 typedef struct xcd_thread_info
 {
     xcd_thread_t t;
+    int          snapshot_selected; //unwound before resuming (live snapshot only)
     TAILQ_ENTRY(xcd_thread_info,) link;
 } xcd_thread_info_t;
+#pragma clang diagnostic pop
 typedef TAILQ_HEAD(xcd_thread_info_queue, xcd_thread_info,) xcd_thread_info_queue_t;
 
 #pragma clang diagnostic push
@@ -71,6 +78,19 @@ struct xcd_process
     xcd_thread_info_queue_t  thds;
     size_t                   nthds;
     xcd_maps_t              *maps;
+
+    //threads suspension
+    int                      suspend_seized; //SEIZE + INTERRUPT, or ATTACH one by one
+    uint64_t                 suspend_seize_us;
+    uint64_t                 suspend_interrupt_us;
+    uint64_t                 suspend_wait_us;
+    uint64_t                 suspend_start_us;
+    uint64_t                 suspend_total_us; //from suspending to resuming
+
+    //live snapshot
+    int                      snapshot_allowlist; //the allowlist regex is used
+    int                      snapshot_matched_regex;
+    int                      snapshot_ignored_by_limit;
 };
 #pragma clang diagnostic pop
 
@@ -90,7 +110,7 @@ static int xcd_process_load_threads(xcd_process_t *self)
         if(0 == strcmp(ent->d_name, "..")) continue;
         if(0 != xcc_util_atoi(ent->d_name, &tid)) continue;
         
-        if(NULL == (thd = malloc(sizeof(xcd_thread_info_t)))) return XCC_ERRNO_NOMEM;
+        if(NULL == (thd = xcd_arena_alloc(sizeof(xcd_thread_info_t)))) return XCC_ERRNO_NOMEM;
         xcd_thread_init(&(thd->t), self->pid, tid);
         
         TAILQ_INSERT_TAIL(&(self->thds), thd, link);
@@ -106,13 +126,19 @@ int xcd_process_create(xcd_process_t **self, pid_t pid, pid_t crash_tid, siginfo
     int                r;
     xcd_thread_info_t *thd;
     
-    if(NULL == (*self = malloc(sizeof(xcd_process_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (*self = xcd_arena_alloc(sizeof(xcd_process_t)))) return XCC_ERRNO_NOMEM;
     (*self)->pid       = pid;
     (*self)->pname     = NULL;
     (*self)->crash_tid = crash_tid;
     (*self)->si        = si;
     (*self)->uc        = uc;
     (*self)->nthds     = 0;
+    (*self)->suspend_seized       = 0;
+    (*self)->suspend_seize_us     = 0;
+    (*self)->suspend_interrupt_us = 0;
+    (*self)->suspend_wait_us      = 0;
+    (*self)->suspend_start_us     = 0;
+    (*self)->suspend_total_us     = 0;
     TAILQ_INIT(&((*self)->thds));
 
     if(0 != (r = xcd_process_load_threads(*self)))
@@ -137,11 +163,70 @@ size_t xcd_process_get_number_of_threads(xcd_process_t *self)
     return self->nthds;
 }
 
+static uint64_t xcd_process_get_time_us(void)
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
 void xcd_process_suspend_threads(xcd_process_t *self)
 {
     xcd_thread_info_t *thd;
+    uint64_t           t0, t1, t2, t3;
+    int                r;
+    int                seize_unsupported = 0;
+
+    //seize all the threads first (they keep running), then stop them all, then reap all the stops,
+    //so the freeze window does not grow with the number of threads
+    t0 = self->suspend_start_us = xcd_process_get_time_us();
+    TAILQ_FOREACH(thd, &(self->thds), link)
+    {
+        r = xcd_thread_seize(&(thd->t));
+        if(EIO == r || EINVAL == r) seize_unsupported = 1;
+    }
+    if(seize_unsupported)
+    {
+        //PTRACE_SEIZE is not supported (linux < 3.4), attach and wait one by one
+        //(a thread which has exited before its SEIZE does not decide this)
+        TAILQ_FOREACH(thd, &(self->thds), link)
+        {
+            if(XCD_THREAD_STATUS_OK == thd->t.status)
+            {
+                //seized already
+                xcd_thread_interrupt(&(thd->t));
+                xcd_thread_wait_stop(&(thd->t));
+            }
+            else
+            {
+                thd->t.status = XCD_THREAD_STATUS_OK;
+                xcd_thread_suspend(&(thd->t));
+            }
+        }
+        self->suspend_wait_us = xcd_process_get_time_us() - t0;
+        return;
+    }
+    t1 = xcd_process_get_time_us();
     TAILQ_FOREACH(thd, &(self->thds), link)
-        xcd_thread_suspend(&(thd->t));
+        xcd_thread_interrupt(&(thd->t));
+    t2 = xcd_process_get_time_us();
+    TAILQ_FOREACH(thd, &(self->thds), link)
+        xcd_thread_wait_stop(&(thd->t));
+    t3 = xcd_process_get_time_us();
+
+    self->suspend_seized = 1;
+    self->suspend_seize_us = t1 - t0;
+    self->suspend_interrupt_us = t2 - t1;
+    self->suspend_wait_us = t3 - t2;
+}
+
+//after the threads are resumed, the writable memory is no longer consistent with the stack snapshots,
+//the read-only mappings (code of the memory-backed ELFs, e.g. vdso and JIT) are still read for the function names
+void xcd_process_set_snapshots_only(xcd_process_t *self)
+{
+    if(NULL != self->maps) xcd_maps_add_readonly(self->maps);
+    xcd_util_set_snapshots_only();
 }
 
 void xcd_process_resume_threads(xcd_process_t *self)
@@ -149,6 +234,7 @@ void xcd_process_resume_threads(xcd_process_t *self)
     xcd_thread_info_t *thd;
     TAILQ_FOREACH(thd, &(self->thds), link)
         xcd_thread_resume(&(thd->t));
+    self->suspend_total_us = xcd_process_get_time_us() - self->suspend_start_us;
 }
 
 int xcd_process_load_info(xcd_process_t *self)
@@ -158,7 +244,7 @@ int xcd_process_load_info(xcd_process_t *self)
     char               buf[256];
     
     xcc_util_get_process_name(self->pid, buf, sizeof(buf));
-    if(NULL == (self->pname = strdup(buf))) self->pname = "unknown";
+    if(NULL == (self->pname = xcd_arena_strdup(buf))) self->pname = "unknown";
 
     TAILQ_FOREACH(thd, &(self->thds), link)
     {
@@ -166,7 +252,7 @@ int xcd_process_load_info(xcd_process_t *self)
         xcd_thread_load_info(&(thd->t));
         
         //load thread regs
-        if(thd->t.tid != self->crash_tid)
+        if(thd->t.tid != self->crash_tid || NULL == self->uc)
             xcd_thread_load_regs(&(thd->t));
         else
             xcd_thread_load_regs_from_ucontext(&(thd->t), self->uc);
@@ -174,7 +260,10 @@ int xcd_process_load_info(xcd_process_t *self)
 
     //load maps
     if(0 != (r = xcd_maps_create(&(self->maps), self->pid)))
+    {
         XCD_LOG_ERROR("PROCESS: create maps failed, errno=%d", r);
+        return 0;
+    }
 
     return 0;
 }
@@ -348,7 +437,7 @@ static regex_t *xcd_process_build_allowlist_regex(char *dump_all_threads_allowli
     cnt += 1;
 
     regex_t *re = NULL;
-    if(NULL == (re = calloc(cnt, sizeof(regex_t)))) return NULL;
+    if(NULL == (re = xcd_arena_heap_calloc(cnt, sizeof(regex_t)))) return NULL;
 
     char *tmp;
     char *regex_str = strtok_r(dump_all_threads_allowlist, "|", &tmp);
@@ -367,7 +456,7 @@ static regex_t *xcd_process_build_allowlist_regex(char *dump_all_threads_allowli
 
     if(0 == i)
     {
-        free(re);
+        xcd_arena_heap_free(re);
         return NULL;
     }
 
@@ -387,12 +476,116 @@ static int xcd_process_if_need_dump(char *tname, regex_t *re, size_t re_cnt)
     return 0;
 }
 
+//for live snapshot, unwind the selected threads before resuming them,
+//only the pc/sp lists are collected here, the symbolization is done after resuming
+void xcd_process_load_snapshot_frames(xcd_process_t *self,
+                                      unsigned int dump_all_threads_count_max,
+                                      char *dump_all_threads_allowlist)
+{
+    xcd_thread_info_t *thd;
+    regex_t           *re = NULL;
+    size_t             re_cnt = 0;
+    unsigned int       thd_selected = 0;
+
+    //parse thread name allowlist regex
+    re = xcd_process_build_allowlist_regex(dump_all_threads_allowlist, &re_cnt);
+    self->snapshot_allowlist = (NULL != re && re_cnt > 0);
+
+    TAILQ_FOREACH(thd, &(self->thds), link)
+    {
+        //check regex for thread name
+        if(NULL != re && re_cnt > 0 && !xcd_process_if_need_dump(thd->t.tname, re, re_cnt))
+        {
+            continue;
+        }
+        self->snapshot_matched_regex++;
+
+        //check dump count limit
+        if(dump_all_threads_count_max > 0 && thd_selected >= dump_all_threads_count_max)
+        {
+            self->snapshot_ignored_by_limit++;
+            continue;
+        }
+
+        thd->snapshot_selected = 1;
+        thd_selected++;
+        xcd_thread_load_frames(&(thd->t), self->maps, 0);
+    }
+}
+
+//for live snapshot, all threads have been resumed,
+//only the states loaded by xcd_process_load_info() and xcd_process_load_snapshot_frames() are used
+int xcd_process_record_snapshot(xcd_process_t *self,
+                                int log_fd,
+                                unsigned int dump_all_threads_count_max)
+{
+    int                r = 0;
+    xcd_thread_info_t *thd;
+    unsigned int       thd_dumped = 0;
+
+    TAILQ_FOREACH(thd, &(self->thds), link)
+    {
+        if(!thd->snapshot_selected) continue;
+
+        if(0 != thd_dumped)
+            if(0 != (r = xcc_util_write_str(log_fd, XCC_UTIL_THREAD_SEP))) goto end;
+        xcd_bin_record_thread(self->pid, thd->t.tid, 0, thd->t.tname, self->pname);
+        if(0 != (r = xcd_thread_record_info(&(thd->t), log_fd, self->pname))) goto end;
+        if(0 != (r = xcd_thread_record_regs(&(thd->t), log_fd))) goto end;
+        if(0 == xcd_thread_symbolize_frames(&(thd->t)))
+        {
+            if(0 != (r = xcd_thread_record_backtrace(&(thd->t), log_fd))) goto end;
+            if(0 != (r = xcd_thread_record_stack(&(thd->t), log_fd))) goto end;
+        }
+        if(0 != (r = xcc_util_writer_flush())) goto end;
+        thd_dumped++;
+    }
+
+ end:
+    if(0 != (r = xcc_util_write_str(log_fd, XCC_UTIL_THREAD_SEP))) goto ret;
+    if(0 != (r = xcc_util_write_format(log_fd, "total threads: %zu\n", self->nthds))) goto ret;
+    if(self->snapshot_allowlist)
+        if(0 != (r = xcc_util_write_format(log_fd, "threads matched allowlist: %d\n", self->snapshot_matched_regex))) goto ret;
+    if(dump_all_threads_count_max > 0)
+        if(0 != (r = xcc_util_write_format(log_fd, "threads ignored by max count limit: %d\n", self->snapshot_ignored_by_limit))) goto ret;
+    if(0 != (r = xcc_util_write_format(log_fd, "dumped threads: %u\n", thd_dumped))) goto ret;
+    if(self->suspend_seized)
+    {
+        if(0 != (r = xcc_util_write_format(log_fd, "threads suspended by seize: %"PRIu64" us, interrupt: %"PRIu64" us, wait: %"PRIu64" us, total: %"PRIu64" us\n",
+                                           self->suspend_seize_us, self->suspend_interrupt_us, self->suspend_wait_us, self->suspend_total_us))) goto ret;
+    }
+    else
+    {
+        if(0 != (r = xcc_util_write_format(log_fd, "threads suspended by attach: %"PRIu64" us, total: %"PRIu64" us\n",
+                                           self->suspend_wait_us, self->suspend_total_us))) goto ret;
+    }
+    if(0 != (r = xcd_arena_record(log_fd))) goto ret;
+    if(0 != (r = xcc_util_write_str(log_fd, XCC_UTIL_THREAD_END))) goto ret;
+
+ ret:
+    return r;
+}
+
+//the map table is written before the threads, so that an incomplete binary tombstone still has the map names
+void xcd_process_record_bin_maps(xcd_process_t *self)
+{
+    if(NULL != self->maps) xcd_maps_record_bin(self->maps);
+    xcd_bin_flush();
+}
+
+//the load biases are known only after the ELFs are loaded by the unwinding
+void xcd_process_record_bin_load_bias(xcd_process_t *self)
+{
+    if(NULL != self->maps) xcd_maps_record_bin_load_bias(self->maps);
+}
+
 int xcd_process_record(xcd_process_t *self,
                        int log_fd,
                        unsigned int logcat_system_lines,
                        unsigned int logcat_events_lines,
                        unsigned int logcat_main_lines,
                        int dump_elf_hash,
+                       int defer_symbols,
                        int dump_map,
                        int dump_fds,
                        int dump_network_info,
@@ -413,22 +606,25 @@ int xcd_process_record(xcd_process_t *self,
     {
         if(thd->t.tid == self->crash_tid)
         {
+            xcd_bin_record_thread(self->pid, thd->t.tid, 1, thd->t.tname, self->pname);
             if(0 != (r = xcd_thread_record_info(&(thd->t), log_fd, self->pname))) return r;
             if(0 != (r = xcd_process_record_signal_info(self, log_fd))) return r;
             if(0 != (r = xcd_process_record_abort_message(self, log_fd, api_level))) return r;
             if(0 != (r = xcd_thread_record_regs(&(thd->t), log_fd))) return r;
-            if(0 == xcd_thread_load_frames(&(thd->t), self->maps))
+            if(0 == xcd_thread_load_frames(&(thd->t), self->maps, !defer_symbols))
             {
                 if(0 != (r = xcd_thread_record_backtrace(&(thd->t), log_fd))) return r;
-                if(0 != (r = xcd_thread_record_buildid(&(thd->t), log_fd, dump_elf_hash, xcc_util_signal_has_si_addr(self->si) ? (uintptr_t)self->si->si_addr : 0))) return r;
+                if(0 != (r = xcd_thread_record_buildid(&(thd->t), log_fd, dump_elf_hash && !defer_symbols, xcc_util_signal_has_si_addr(self->si) ? (uintptr_t)self->si->si_addr : 0))) return r;
                 if(0 != (r = xcd_thread_record_stack(&(thd->t), log_fd))) return r;
                 if(0 != (r = xcd_thread_record_memory(&(thd->t), log_fd))) return r;
             }
+            if(0 != (r = xcc_util_writer_flush())) return r;
             if(dump_map) if(0 != (r = xcd_maps_record(self->maps, log_fd))) return r;
             if(0 != (r = xcc_util_record_logcat(log_fd, self->pid, api_level, logcat_system_lines, logcat_events_lines, logcat_main_lines))) return r;
             if(dump_fds) if(0 != (r = xcc_util_record_fds(log_fd, self->pid))) return r;
             if(dump_network_info) if(0 != (r = xcc_util_record_network_info(log_fd, self->pid, api_level))) return r;
             if(0 != (r = xcc_meminfo_record(log_fd, self->pid))) return r;
+            if(0 != (r = xcc_util_writer_flush())) return r;
 
             break;
         }
@@ -457,13 +653,17 @@ int xcd_process_record(xcd_process_t *self,
             }
 
             if(0 != (r = xcc_util_write_str(log_fd, XCC_UTIL_THREAD_SEP))) goto end;
+            xcd_bin_record_thread(self->pid, thd->t.tid, 0, thd->t.tname, self->pname);
             if(0 != (r = xcd_thread_record_info(&(thd->t), log_fd, self->pname))) goto end;
             if(0 != (r = xcd_thread_record_regs(&(thd->t), log_fd))) goto end;
-            if(0 == xcd_thread_load_frames(&(thd->t), self->maps))
+            if(0 == xcd_thread_load_frames(&(thd->t), self->maps, !defer_symbols))
             {
                 if(0 != (r = xcd_thread_record_backtrace(&(thd->t), log_fd))) goto end;
+                //the post-processor verifies the on-disk libraries with the build-ids before symbolizing
+                if(defer_symbols) if(0 != (r = xcd_thread_record_buildid(&(thd->t), log_fd, 0, 0))) goto end;
                 if(0 != (r = xcd_thread_record_stack(&(thd->t), log_fd))) goto end;
             }
+            if(0 != (r = xcc_util_writer_flush())) goto end;
             thd_dumped++;
         }
     }
@@ -480,6 +680,16 @@ int xcd_process_record(xcd_process_t *self,
         if(dump_all_threads_count_max > 0)
             if(0 != (r = xcc_util_write_format(log_fd, "threads ignored by max count limit: %d\n", thd_ignored_by_limit))) goto ret;
         if(0 != (r = xcc_util_write_format(log_fd, "dumped threads: %u\n", thd_dumped))) goto ret;
+        if(self->suspend_seized)
+        {
+            if(0 != (r = xcc_util_write_format(log_fd, "threads suspended by seize: %"PRIu64" us, interrupt: %"PRIu64" us, wait: %"PRIu64" us\n",
+                                               self->suspend_seize_us, self->suspend_interrupt_us, self->suspend_wait_us))) goto ret;
+        }
+        else
+        {
+            if(0 != (r = xcc_util_write_format(log_fd, "threads suspended by attach: %"PRIu64" us\n", self->suspend_wait_us))) goto ret;
+        }
+        if(0 != (r = xcd_arena_record(log_fd))) goto ret;
         
         if(0 != (r = xcc_util_write_str(log_fd, XCC_UTIL_THREAD_END))) goto ret;
     }
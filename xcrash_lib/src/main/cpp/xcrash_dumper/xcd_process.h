@@ -39,6 +39,7 @@ size_t xcd_process_get_number_of_threads(xcd_process_t *self);
 
 void xcd_process_suspend_threads(xcd_process_t *self);
 void xcd_process_resume_threads(xcd_process_t *self);
+void xcd_process_set_snapshots_only(xcd_process_t *self);
 
 int xcd_process_load_info(xcd_process_t *self);
 
@@ -48,6 +49,7 @@ int xcd_process_record(xcd_process_t *self,
                        unsigned int logcat_events_lines,
                        unsigned int logcat_main_lines,
                        int dump_elf_hash,
+                       int defer_symbols,
                        int dump_map,
                        int dump_fds,
                        int dump_network_info,
@@ -56,6 +58,16 @@ int xcd_process_record(xcd_process_t *self,
                        char *dump_all_threads_allowlist,
                        int api_level);
 
+void xcd_process_record_bin_maps(xcd_process_t *self);
+void xcd_process_record_bin_load_bias(xcd_process_t *self);
+
+void xcd_process_load_snapshot_frames(xcd_process_t *self,
+                                      unsigned int dump_all_threads_count_max,
+                                      char *dump_all_threads_allowlist);
+int xcd_process_record_snapshot(xcd_process_t *self,
+                                int log_fd,
+                                unsigned int dump_all_threads_count_max);
+
 #ifdef __cplusplus
 }
 #endif
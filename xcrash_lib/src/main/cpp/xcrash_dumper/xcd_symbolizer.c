@@ -0,0 +1,361 @@
+// Copyright (c) 2020-present, HexHacking Team. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "queue.h"
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcd_symbolizer.h"
+#include "xcd_map.h"
+#include "xcd_elf.h"
+#include "xcd_md5.h"
+#include "xcd_arena.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+
+#define XCD_SYMBOLIZER_WRITER_BUF_SIZE (64 * 1024)
+
+#define XCD_SYMBOLIZER_SECTION_NONE      0
+#define XCD_SYMBOLIZER_SECTION_BACKTRACE 1
+#define XCD_SYMBOLIZER_SECTION_BUILD_ID  2
+
+//a library recorded in the "build id" sections of the raw tombstone
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct xcd_symbolizer_lib
+{
+    char  *name;
+    char  *build_id;  //hex string or "unknown"
+    off_t  file_size; //-1 if not recorded
+    TAILQ_ENTRY(xcd_symbolizer_lib,) link;
+} xcd_symbolizer_lib_t;
+#pragma clang diagnostic pop
+typedef TAILQ_HEAD(xcd_symbolizer_lib_queue, xcd_symbolizer_lib,) xcd_symbolizer_lib_queue_t;
+
+//an ELF loaded from the on-disk library (or the file it is embedded in)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct xcd_symbolizer_elf
+{
+    xcd_map_t  map;
+    size_t     elf_start_offset;
+    xcd_elf_t *elf; //NULL if the library can not be verified
+    TAILQ_ENTRY(xcd_symbolizer_elf,) link;
+} xcd_symbolizer_elf_t;
+#pragma clang diagnostic pop
+typedef TAILQ_HEAD(xcd_symbolizer_elf_queue, xcd_symbolizer_elf,) xcd_symbolizer_elf_queue_t;
+
+static xcd_symbolizer_lib_queue_t xcd_symbolizer_libs = TAILQ_HEAD_INITIALIZER(xcd_symbolizer_libs);
+static xcd_symbolizer_elf_queue_t xcd_symbolizer_elfs = TAILQ_HEAD_INITIALIZER(xcd_symbolizer_elfs);
+
+static char *xcd_symbolizer_strndup(const char *s, size_t n)
+{
+    char *d;
+
+    if(NULL == (d = xcd_arena_calloc(1, n + 1))) return NULL;
+    memcpy(d, s, n);
+    return d;
+}
+
+//"    /data/app/.../lib/arm64/libtest.so (BuildId: 0123abcd. FileSize: 12345. LastModified: ...)"
+static void xcd_symbolizer_load_lib(const char *line)
+{
+    xcd_symbolizer_lib_t *lib;
+    const char           *p, *build_id;
+
+    if(0 != strncmp(line, "    /", 5)) return;
+    if(NULL == (p = strstr(line + 4, " (BuildId: "))) return;
+    build_id = p + 11;
+
+    //the first one wins
+    TAILQ_FOREACH(lib, &xcd_symbolizer_libs, link)
+        if(strlen(lib->name) == (size_t)(p - line - 4) && 0 == memcmp(lib->name, line + 4, (size_t)(p - line - 4))) return;
+
+    if(NULL == (lib = xcd_arena_alloc(sizeof(xcd_symbolizer_lib_t)))) return;
+    if(NULL == (lib->name = xcd_symbolizer_strndup(line + 4, (size_t)(p - line - 4)))) return;
+    if(NULL == (lib->build_id = xcd_symbolizer_strndup(build_id, strcspn(build_id, ".)")))) return;
+    lib->file_size = (NULL == (p = strstr(build_id, ". FileSize: ")) ? -1 : (off_t)strtoll(p + 12, NULL, 10));
+    TAILQ_INSERT_TAIL(&xcd_symbolizer_libs, lib, link);
+}
+
+static xcd_symbolizer_lib_t *xcd_symbolizer_find_lib(const char *name)
+{
+    xcd_symbolizer_lib_t *lib;
+
+    TAILQ_FOREACH(lib, &xcd_symbolizer_libs, link)
+        if(0 == strcmp(lib->name, name)) return lib;
+    
+    return NULL;
+}
+
+//the library on disk may have been updated or removed since the crash
+static int xcd_symbolizer_verify_elf(xcd_symbolizer_elf_t *self, xcd_symbolizer_lib_t *lib)
+{
+    uint8_t build_id[64];
+    size_t  build_id_len = 0, i;
+    char    hex[sizeof(build_id) * 2 + 1];
+    
+    //the build-id line belongs to the first ELF found in the file
+    if(0 != self->elf_start_offset || 0 == strcmp(lib->build_id, "unknown")) return 0;
+
+    if(0 != xcd_elf_get_build_id(self->elf, build_id, sizeof(build_id), &build_id_len)) return XCC_ERRNO_MISSING;
+    for(i = 0; i < build_id_len; i++)
+        snprintf(hex + i * 2, sizeof(hex) - i * 2, "%02hhx", build_id[i]);
+    hex[build_id_len * 2] = '\0';
+    
+    return 0 == strcmp(hex, lib->build_id) ? 0 : XCC_ERRNO_MISSING;
+}
+
+static xcd_elf_t *xcd_symbolizer_get_elf(const char *name, size_t elf_start_offset)
+{
+    xcd_symbolizer_elf_t *e;
+    xcd_symbolizer_lib_t *lib;
+    struct stat           st;
+
+    TAILQ_FOREACH(e, &xcd_symbolizer_elfs, link)
+        if(e->elf_start_offset == elf_start_offset && 0 == strcmp(e->map.name, name)) return e->elf;
+
+    if(NULL == (e = xcd_arena_alloc(sizeof(xcd_symbolizer_elf_t)))) return NULL;
+    e->elf_start_offset = elf_start_offset;
+    e->elf = NULL;
+    xcd_map_init(&(e->map), 0, 0, 0, "---p", 0, 0, xcd_arena_strdup(name));
+    if(NULL == e->map.name) return NULL;
+    TAILQ_INSERT_TAIL(&xcd_symbolizer_elfs, e, link);
+
+    //check the file size recorded at crash time
+    if(NULL == (lib = xcd_symbolizer_find_lib(name)) || lib->file_size < 0) return NULL;
+    if(0 != stat(name, &st) || st.st_size != lib->file_size || (off_t)elf_start_offset >= st.st_size) return NULL;
+
+    //map the ELF from the file only (no PROT_READ, no ptrace)
+    e->map.offset = elf_start_offset;
+    e->map.end = (uintptr_t)(st.st_size - (off_t)elf_start_offset);
+    if(NULL == (e->elf = xcd_map_get_elf(&(e->map), 0, NULL))) return NULL;
+    if(e->map.elf_start_offset != elf_start_offset || 0 != xcd_symbolizer_verify_elf(e, lib)) e->elf = NULL;
+
+    return e->elf;
+}
+
+//"    #00 pc 000000000001e2b4  /data/app/.../base.apk!libtest.so (offset 0x1000)"
+static void xcd_symbolizer_render_frame(char *line, size_t line_size)
+{
+    char      *p, *end, *name;
+    uintptr_t  rel_pc;
+    size_t     elf_start_offset = 0, name_len, func_offset = 0;
+    char      *func_name = NULL;
+    xcd_elf_t *elf;
+    size_t     len = strlen(line);
+
+    //pc
+    if(0 != strncmp(line, "    #", 5) || NULL == (p = strstr(line, " pc "))) return;
+    rel_pc = (uintptr_t)strtoull(p + 4, &end, 16);
+    if(end == p + 4 || 0 != strncmp(end, "  /", 3)) return;
+    name = end + 2;
+
+    //offset
+    if(NULL != (p = strstr(name, " (offset 0x")))
+    {
+        elf_start_offset = (size_t)strtoull(p + 11, &end, 16);
+        if(')' != end[0] || '\0' != end[1]) return; //symbolized already
+        name_len = (size_t)(p - name);
+    }
+    else
+    {
+        if(')' == line[len - 1]) return; //symbolized already
+        name_len = len - (size_t)(name - line);
+    }
+
+    //name of the embedded ELF
+    if(NULL != (p = memchr(name, '!', name_len))) name_len = (size_t)(p - name);
+
+    if(NULL == (name = xcd_symbolizer_strndup(name, name_len))) return;
+    if(NULL == (elf = xcd_symbolizer_get_elf(name, elf_start_offset))) return;
+    if(0 != xcd_elf_get_function_info(elf, rel_pc, &func_name, &func_offset) || NULL == func_name) return;
+
+    if(func_offset > 0)
+        snprintf(line + len, line_size - len, " (%s+%zu)", func_name, func_offset);
+    else
+        snprintf(line + len, line_size - len, " (%s)", func_name);
+    xcd_arena_heap_free(func_name);
+}
+
+//the MD5 of the on-disk library is the same as the one at crash time, after it has been verified
+static void xcd_symbolizer_render_buildid(char *line, size_t line_size)
+{
+    char        *p, *name;
+    size_t       len = strlen(line), name_len, i;
+    int          fd = -1;
+    struct stat  st;
+    uint8_t     *data;
+    uint8_t      md5[16];
+    xcd_MD5_CTX  ctx;
+    char         md5_str[sizeof(md5) * 2 + 1];
+
+    if(0 != strncmp(line, "    /", 5) || ')' != line[len - 1]) return;
+    if(NULL == (p = strstr(line + 4, " (BuildId: "))) return;
+    if(NULL == strstr(p, ". FileSize: ") || NULL != strstr(p, " error: ") || NULL != strstr(p, ". MD5: ")) return;
+
+    name_len = (size_t)(p - line - 4);
+    if(!((name_len > 3 && 0 == memcmp(line + 4 + name_len - 3, ".so", 3))
+         || (name_len > 12 && 0 == memcmp(line + 4, "/system/bin/", 12)))) return;
+
+    if(NULL == (name = xcd_symbolizer_strndup(line + 4, name_len))) return;
+    if(NULL == xcd_symbolizer_get_elf(name, 0)) return;
+
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(name, O_RDONLY | O_CLOEXEC)))) return;
+    if(0 != fstat(fd, &st) || st.st_size <= 0) goto end;
+    if(MAP_FAILED == (data = (uint8_t *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0))) goto end;
+    xcd_MD5_Init(&ctx);
+    xcd_MD5_Update(&ctx, data, (unsigned long)st.st_size);
+    xcd_MD5_Final(md5, &ctx);
+    munmap(data, (size_t)st.st_size);
+
+    for(i = 0; i < sizeof(md5); i++)
+        snprintf(md5_str + i * 2, sizeof(md5_str) - i * 2, "%02hhx", md5[i]);
+    snprintf(line + len - 1, line_size - (len - 1), ". MD5: %s)", md5_str);
+
+ end:
+    close(fd);
+}
+
+static int xcd_symbolizer_get_section(const char *line, int section)
+{
+    if(0 == strcmp(line, "backtrace:")) return XCD_SYMBOLIZER_SECTION_BACKTRACE;
+    if(0 == strcmp(line, "build id:")) return XCD_SYMBOLIZER_SECTION_BUILD_ID;
+    if('\0' == line[0]) return XCD_SYMBOLIZER_SECTION_NONE;
+    return section;
+}
+
+static int xcd_symbolizer_read_file(const char *pathname, char **buf, size_t *len)
+{
+    int         fd;
+    struct stat st;
+    size_t      nread = 0;
+    ssize_t     n;
+    int         r = XCC_ERRNO_SYS;
+
+    *buf = NULL;
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, O_RDONLY | O_CLOEXEC)))) return XCC_ERRNO_SYS;
+    if(0 != fstat(fd, &st) || st.st_size <= 0) goto end;
+    if(NULL == (*buf = xcd_arena_heap_malloc((size_t)st.st_size + 1)))
+    {
+        r = XCC_ERRNO_NOMEM;
+        goto end;
+    }
+    while(nread < (size_t)st.st_size)
+    {
+        if(0 >= (n = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, *buf + nread, (size_t)st.st_size - nread)))) break;
+        nread += (size_t)n;
+    }
+    (*buf)[nread] = '\0';
+
+    //the rest of the placeholder file is zero-filled
+    *len = strlen(*buf);
+    r = 0;
+
+ end:
+    close(fd);
+    if(0 != r && NULL != *buf)
+    {
+        xcd_arena_heap_free(*buf);
+        *buf = NULL;
+    }
+    return r;
+}
+
+int xcd_symbolizer_render(const char *raw_pathname, const char *pathname, int dump_elf_hash)
+{
+    char   *buf = NULL, *p, *end;
+    char    line[2048];
+    size_t  len, line_len;
+    int     fd = -1, section, r;
+
+    if(0 != (r = xcd_symbolizer_read_file(raw_pathname, &buf, &len))) return r;
+
+    //pass 1: libraries in all the "build id" sections
+    section = XCD_SYMBOLIZER_SECTION_NONE;
+    for(p = buf; p < buf + len; p = end + 1)
+    {
+        if(NULL == (end = memchr(p, '\n', (size_t)(buf + len - p)))) end = buf + len;
+        if((line_len = (size_t)(end - p)) >= sizeof(line)) continue;
+        memcpy(line, p, line_len);
+        line[line_len] = '\0';
+
+        if(XCD_SYMBOLIZER_SECTION_BUILD_ID == section) xcd_symbolizer_load_lib(line);
+        section = xcd_symbolizer_get_section(line, section);
+    }
+
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, O_CREAT | O_WRONLY | O_CLOEXEC | O_TRUNC,
+                                                  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH))))
+    {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+    xcc_util_writer_init(fd, XCD_SYMBOLIZER_WRITER_BUF_SIZE);
+
+    //pass 2: copy the lines, append the function names and the ELF hashes
+    section = XCD_SYMBOLIZER_SECTION_NONE;
+    for(p = buf; p < buf + len; p = end + 1)
+    {
+        if(NULL == (end = memchr(p, '\n', (size_t)(buf + len - p)))) end = buf + len;
+        if((line_len = (size_t)(end - p)) >= sizeof(line) / 2)
+        {
+            //too long to be a frame, keep it as it is
+            if(0 != (r = xcc_util_write(fd, p, end < buf + len ? line_len + 1 : line_len))) goto end;
+            continue;
+        }
+        memcpy(line, p, line_len);
+        line[line_len] = '\0';
+
+        if(XCD_SYMBOLIZER_SECTION_BACKTRACE == section)
+            xcd_symbolizer_render_frame(line, sizeof(line));
+        else if(XCD_SYMBOLIZER_SECTION_BUILD_ID == section && dump_elf_hash)
+            xcd_symbolizer_render_buildid(line, sizeof(line));
+        section = xcd_symbolizer_get_section(line, section);
+
+        if(0 != (r = xcc_util_write_str(fd, line))) goto end;
+        if(end < buf + len)
+            if(0 != (r = xcc_util_write(fd, "\n", 1))) goto end;
+    }
+
+    r = xcc_util_writer_uninit();
+
+ end:
+    xcc_util_writer_uninit();
+    if(fd >= 0) close(fd);
+    xcd_arena_heap_free(buf);
+    return r;
+}
+
+#pragma clang diagnostic pop
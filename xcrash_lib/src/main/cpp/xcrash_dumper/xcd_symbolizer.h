@@ -0,0 +1,42 @@
+// Copyright (c) 2020-present, HexHacking Team. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef XCD_SYMBOLIZER_H
+#define XCD_SYMBOLIZER_H 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//deferred symbolization
+//
+//The raw tombstone (.native-raw.xcrash) is written at crash time without the function names and the ELF hashes.
+//It is rendered into the final tombstone on the next launch, against the on-disk libraries.
+//A library is used only if it is verified by the FileSize and BuildId recorded in the "build id" sections,
+//otherwise the frames in it are kept as they are.
+int xcd_symbolizer_render(const char *raw_pathname, const char *pathname, int dump_elf_hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -28,8 +28,10 @@
 #include <time.h>
 #include "xcc_util.h"
 #include "xcd_sys.h"
+#include "xcd_bin.h"
 
 int xcd_sys_record(int fd,
+                   const char *crash_type,
                    long time_zone,
                    uint64_t start_time,
                    uint64_t crash_time,
@@ -46,7 +48,7 @@ int xcd_sys_record(int fd,
 {
     char buf[1024];
     xcc_util_get_dump_header(buf, sizeof(buf),
-                             XCC_UTIL_CRASH_TYPE_NATIVE,
+                             crash_type,
                              time_zone,
                              start_time,
                              crash_time,
@@ -60,5 +62,6 @@ int xcd_sys_record(int fd,
                              brand,
                              model,
                              build_fingerprint);
+    xcd_bin_record_header(buf);
     return xcc_util_write_str(fd, buf);
 }
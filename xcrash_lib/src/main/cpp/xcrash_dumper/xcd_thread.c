@@ -44,6 +44,19 @@
 #include "xcd_regs.h"
 #include "xcd_util.h"
 #include "xcd_log.h"
+#include "xcd_arena.h"
+
+#ifndef PTRACE_SEIZE
+#define PTRACE_SEIZE     0x4206
+#endif
+#ifndef PTRACE_INTERRUPT
+#define PTRACE_INTERRUPT 0x4207
+#endif
+
+//max number of bytes of the stack snapshot (start from SP)
+#define XCD_THREAD_STACK_SNAPSHOT_SIZE       (64 * 1024)
+//number of bytes below SP to be included in the stack snapshot (red zone, words dumped before the first frame)
+#define XCD_THREAD_STACK_SNAPSHOT_BELOW_SP   256
 
 void xcd_thread_init(xcd_thread_t *self, pid_t pid, pid_t tid)
 {
@@ -52,6 +65,9 @@ void xcd_thread_init(xcd_thread_t *self, pid_t pid, pid_t tid)
     self->tid    = tid;
     self->tname  = NULL;
     self->frames = NULL;
+    self->stack  = NULL;
+    self->stack_start = 0;
+    self->stack_size  = 0;
     memset(&(self->regs), 0, sizeof(self->regs));
 }
 
@@ -66,6 +82,42 @@ void xcd_thread_suspend(xcd_thread_t *self)
         return;
     }
 
+    xcd_thread_wait_stop(self);
+}
+
+//attach without stopping the thread, return errno on failure
+int xcd_thread_seize(xcd_thread_t *self)
+{
+    if(0 != ptrace(PTRACE_SEIZE, self->tid, NULL, NULL))
+    {
+#if XCD_THREAD_DEBUG
+        XCD_LOG_WARN("THREAD: ptrace SEIZE failed, errno=%d", errno);
+#endif
+        self->status = XCD_THREAD_STATUS_ATTACH;
+        return errno;
+    }
+    return 0;
+}
+
+void xcd_thread_interrupt(xcd_thread_t *self)
+{
+    if(XCD_THREAD_STATUS_OK != self->status) return;
+    
+    if(0 != ptrace(PTRACE_INTERRUPT, self->tid, NULL, NULL))
+    {
+        ptrace(PTRACE_DETACH, self->tid, NULL, NULL);
+#if XCD_THREAD_DEBUG
+        XCD_LOG_WARN("THREAD: ptrace INTERRUPT failed, errno=%d", errno);
+#endif
+        self->status = XCD_THREAD_STATUS_ATTACH;
+    }
+}
+
+//wait for the stop after ATTACH or INTERRUPT
+void xcd_thread_wait_stop(xcd_thread_t *self)
+{
+    if(XCD_THREAD_STATUS_OK != self->status) return;
+    
     errno = 0;
     while(waitpid(self->tid, NULL, __WALL) < 0)
     {
@@ -92,7 +144,7 @@ void xcd_thread_load_info(xcd_thread_t *self)
     char buf[64] = "\0";
     
     xcc_util_get_thread_name(self->tid, buf, sizeof(buf));
-    if(NULL == (self->tname = strdup(buf))) self->tname = "unknown";
+    if(NULL == (self->tname = xcd_arena_strdup(buf))) self->tname = "unknown";
 }
 
 void xcd_thread_load_regs(xcd_thread_t *self)
@@ -128,7 +180,41 @@ void xcd_thread_load_regs_from_ucontext(xcd_thread_t *self, ucontext_t *uc)
     xcd_regs_load_from_ucontext(&(self->regs), uc);
 }
 
-int xcd_thread_load_frames(xcd_thread_t *self, xcd_maps_t *maps)
+//copy the stack of the suspended thread to local memory with one read,
+//then the unwinding and the stack dumping can read it without syscalls
+static void xcd_thread_load_stack(xcd_thread_t *self, xcd_maps_t *maps)
+{
+    xcd_map_t *map;
+    uintptr_t  sp, start, end;
+    size_t     bytes;
+
+    if(XCD_THREAD_STATUS_OK != self->status) return;
+
+    sp = xcd_regs_get_sp(&(self->regs));
+    if(NULL == (map = xcd_maps_find_map(maps, sp))) return;
+    if(!(map->flags & PROT_READ)) return; //e.g. stack overflow into the guard page
+
+    //clip to the stack mapping
+    start = (sp - map->start > XCD_THREAD_STACK_SNAPSHOT_BELOW_SP ? sp - XCD_THREAD_STACK_SNAPSHOT_BELOW_SP : map->start);
+    end = (map->end - sp > XCD_THREAD_STACK_SNAPSHOT_SIZE ? sp + XCD_THREAD_STACK_SNAPSHOT_SIZE : map->end);
+
+    if(NULL == (self->stack = xcd_arena_heap_malloc(end - start))) return;
+    if(0 == (bytes = xcd_util_ptrace_read(self->pid, start, self->stack, end - start)) ||
+       0 != xcd_util_add_snapshot(start, self->stack, bytes))
+    {
+        xcd_arena_heap_free(self->stack);
+        self->stack = NULL;
+        return;
+    }
+    self->stack_start = start;
+    self->stack_size = bytes;
+
+#if XCD_THREAD_DEBUG
+    XCD_LOG_DEBUG("THREAD: load stack, tid=%d, start=%"PRIxPTR", size=%zu", self->tid, start, bytes);
+#endif
+}
+
+int xcd_thread_load_frames(xcd_thread_t *self, xcd_maps_t *maps, int symbolize)
 {
 #if XCD_THREAD_DEBUG
     XCD_LOG_DEBUG("THREAD: load frames, tid=%d, tname=%s", self->tid, self->tname);
@@ -136,7 +222,10 @@ int xcd_thread_load_frames(xcd_thread_t *self, xcd_maps_t *maps)
 
     if(XCD_THREAD_STATUS_OK != self->status) return XCC_ERRNO_STATE; //do NOT ignore
 
-    return xcd_frames_create(&(self->frames), &(self->regs), maps, self->pid);
+    //only for the threads which will be unwound (crashed, allowlisted and under the count limit)
+    if(NULL == self->stack) xcd_thread_load_stack(self, maps);
+
+    return xcd_frames_create(&(self->frames), &(self->regs), maps, self->pid, symbolize);
 }
 
 int xcd_thread_record_info(xcd_thread_t *self, int log_fd, const char *pname)
@@ -152,6 +241,15 @@ int xcd_thread_record_regs(xcd_thread_t *self, int log_fd)
     return xcd_regs_record(&(self->regs), log_fd);
 }
 
+//for the frames loaded without symbolization
+int xcd_thread_symbolize_frames(xcd_thread_t *self)
+{
+    if(XCD_THREAD_STATUS_OK != self->status || NULL == self->frames) return XCC_ERRNO_STATE;
+
+    xcd_frames_symbolize(self->frames);
+    return 0;
+}
+
 int xcd_thread_record_backtrace(xcd_thread_t *self, int log_fd)
 {
     if(XCD_THREAD_STATUS_OK != self->status) return 0; //ignore
@@ -176,31 +274,36 @@ int xcd_thread_record_stack(xcd_thread_t *self, int log_fd)
 #define XCD_THREAD_MEMORY_BYTES_TO_DUMP 256
 #define XCD_THREAD_MEMORY_BYTES_PER_LINE 16
 
-static int xcd_thread_record_memory_by_addr(xcd_thread_t *self, int log_fd,
-                                            const char *label, uintptr_t addr)
+//return 0 if the address should not be dumped
+static int xcd_thread_get_memory_addr(uintptr_t *addr)
 {
-    int r;
-    
     // Align the address to sizeof(long) and start 32 bytes before the address.
-    addr &= ~(sizeof(long) - 1);
-    if (addr >= 4128) addr -= 32;
+    *addr &= ~(sizeof(long) - 1);
+    if (*addr >= 4128) *addr -= 32;
 
     // Don't bother if the address looks too low, or looks too high.
-    if (addr < 4096 ||
+    if (*addr < 4096 ||
 #if defined(__LP64__)
-        addr > 0x4000000000000000UL - XCD_THREAD_MEMORY_BYTES_TO_DUMP) {
+        *addr > 0x4000000000000000UL - XCD_THREAD_MEMORY_BYTES_TO_DUMP) {
 #else
-        addr > 0xffff0000 - XCD_THREAD_MEMORY_BYTES_TO_DUMP) {
+        *addr > 0xffff0000 - XCD_THREAD_MEMORY_BYTES_TO_DUMP) {
 #endif
-        return 0; //not an error
+        return 0;
     }
 
+    return 1;
+}
+
+//data: XCD_THREAD_MEMORY_BYTES_TO_DUMP bytes at addr, the first "bytes" bytes of them have been read
+static int xcd_thread_record_memory_by_addr(xcd_thread_t *self, int log_fd,
+                                            const char *label, uintptr_t addr,
+                                            uintptr_t *data, size_t bytes)
+{
+    int r;
+
     if(0 != (r = xcc_util_write_format(log_fd, "memory near %s:\n", label))) return r;
     
     // Dump 256 bytes
-    uintptr_t data[XCD_THREAD_MEMORY_BYTES_TO_DUMP/sizeof(uintptr_t)];
-    memset(data, 0, XCD_THREAD_MEMORY_BYTES_TO_DUMP);
-    size_t bytes = xcd_util_ptrace_read(self->pid, addr, data, sizeof(data));
     if (bytes % sizeof(uintptr_t) != 0)
         bytes &= ~(sizeof(uintptr_t) - 1);
     
@@ -226,7 +329,7 @@ static int xcd_thread_record_memory_by_addr(xcd_thread_t *self, int log_fd,
         // to contain at least one page, and the total number of bytes to dump
         // is smaller than a page.
         size_t bytes2 = xcd_util_ptrace_read(self->pid, (uintptr_t)(addr + start + bytes), (uint8_t *)(data) + bytes,
-                                             (size_t)(sizeof(data) - bytes - start));
+                                             (size_t)(XCD_THREAD_MEMORY_BYTES_TO_DUMP - bytes - start));
         bytes += bytes2;
         if(bytes2 > 0 && bytes % sizeof(uintptr_t) != 0)
             bytes &= ~(sizeof(uintptr_t) - 1);
@@ -290,18 +393,45 @@ static int xcd_thread_record_memory_by_addr(xcd_thread_t *self, int log_fd,
 
 int xcd_thread_record_memory(xcd_thread_t *self, int log_fd)
 {
-    xcd_regs_label_t *labels;
-    size_t            labels_count;
-    size_t            i;
-    int               r;
+    xcd_regs_label_t       *labels;
+    size_t                  labels_count;
+    xcd_util_remote_read_t *reqs = NULL;
+    uint8_t                *data = NULL;
+    uintptr_t               addr;
+    size_t                  i;
+    int                     r = 0;
 
     if(XCD_THREAD_STATUS_OK != self->status) return 0; //ignore
 
     xcd_regs_get_labels(&labels, &labels_count);
+    if(0 == labels_count) return 0;
+
+    if(NULL == (reqs = xcd_arena_heap_calloc(labels_count, sizeof(xcd_util_remote_read_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (data = xcd_arena_heap_calloc(labels_count, XCD_THREAD_MEMORY_BYTES_TO_DUMP)))
+    {
+        r = XCC_ERRNO_NOMEM;
+        goto end;
+    }
+
+    //read memory near all the registers at once
+    for(i = 0; i < labels_count; i++)
+    {
+        addr = (uintptr_t)(self->regs.r[labels[i].idx]);
+        reqs[i].addr = addr;
+        reqs[i].dst = data + i * XCD_THREAD_MEMORY_BYTES_TO_DUMP;
+        reqs[i].len = (xcd_thread_get_memory_addr(&(reqs[i].addr)) ? XCD_THREAD_MEMORY_BYTES_TO_DUMP : 0);
+    }
+    xcd_util_remote_readv_batch(self->pid, reqs, labels_count);
     
     for(i = 0; i < labels_count; i++)
-        if(0 != (r = xcd_thread_record_memory_by_addr(self, log_fd, labels[i].name,
-                                                      (uintptr_t)(self->regs.r[labels[i].idx])))) return r;
+    {
+        if(0 == reqs[i].len) continue;
+        if(0 != (r = xcd_thread_record_memory_by_addr(self, log_fd, labels[i].name, reqs[i].addr,
+                                                      (uintptr_t *)(reqs[i].dst), reqs[i].bytes))) goto end;
+    }
 
-    return 0;
+ end:
+    if(NULL != data) xcd_arena_heap_free(data);
+    xcd_arena_heap_free(reqs);
+    return r;
 }
@@ -53,18 +53,25 @@ typedef struct xcd_thread
     char                *tname;
     xcd_regs_t           regs;
     xcd_frames_t        *frames;
+    uint8_t             *stack;
+    uintptr_t            stack_start;
+    size_t               stack_size;
 } xcd_thread_t;
 #pragma clang diagnostic pop
 
 void xcd_thread_init(xcd_thread_t *self, pid_t pid, pid_t tid);
 
 void xcd_thread_suspend(xcd_thread_t *self);
+int xcd_thread_seize(xcd_thread_t *self);
+void xcd_thread_interrupt(xcd_thread_t *self);
+void xcd_thread_wait_stop(xcd_thread_t *self);
 void xcd_thread_resume(xcd_thread_t *self);
 
 void xcd_thread_load_info(xcd_thread_t *self);
 void xcd_thread_load_regs(xcd_thread_t *self);
 void xcd_thread_load_regs_from_ucontext(xcd_thread_t *self, ucontext_t *uc);
-int xcd_thread_load_frames(xcd_thread_t *self, xcd_maps_t *maps);
+int xcd_thread_load_frames(xcd_thread_t *self, xcd_maps_t *maps, int symbolize);
+int xcd_thread_symbolize_frames(xcd_thread_t *self);
 
 int xcd_thread_record_info(xcd_thread_t *self, int log_fd, const char *pname);
 int xcd_thread_record_regs(xcd_thread_t *self, int log_fd);
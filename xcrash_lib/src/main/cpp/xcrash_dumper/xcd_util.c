@@ -30,13 +30,16 @@
 #include <string.h>
 #include <signal.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <sys/ptrace.h>
+#include <sys/uio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include "xcc_errno.h"
 #include "xcc_util.h"
 #include "xcd_util.h"
 #include "xcd_log.h"
+#include "xcd_arena.h"
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wreserved-id-macro"
@@ -46,6 +49,36 @@
 #include "XzCrc64.h"
 #pragma clang diagnostic pop
 
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    uintptr_t      start;
+    size_t         size;
+    const uint8_t *data;
+} xcd_util_snapshot_t;
+#pragma clang diagnostic pop
+
+//local copies of the remote threads' stacks, sorted by start address
+static xcd_util_snapshot_t *xcd_util_snapshots     = NULL;
+static size_t               xcd_util_snapshots_num = 0;
+static size_t               xcd_util_snapshots_cap = 0;
+
+//the remote threads have been resumed, other remote memory is no longer consistent with the snapshots
+static int                  xcd_util_snapshots_only = 0;
+
+typedef struct
+{
+    uintptr_t start;
+    uintptr_t end;
+} xcd_util_readonly_t;
+
+//read-only remote mappings (code, vdso, JIT), still read after the remote threads have been resumed,
+//sorted by start address, adjacent ones are merged (an ELF may span several mappings)
+static xcd_util_readonly_t *xcd_util_readonlys     = NULL;
+static size_t               xcd_util_readonlys_num = 0;
+static size_t               xcd_util_readonlys_cap = 0;
+
 extern __attribute((weak)) ssize_t process_vm_readv(pid_t, const struct iovec *, unsigned long, const struct iovec *, unsigned long, unsigned long);
 
 static size_t xcd_util_process_vm_readv(pid_t pid, uintptr_t remote_addr, void* dst, size_t dst_len)
@@ -140,10 +173,122 @@ static size_t xcd_util_original_ptrace(pid_t pid, uintptr_t remote_addr, void *d
     return bytes_read;
 }
 
+int xcd_util_add_snapshot(uintptr_t start, const void *data, size_t size)
+{
+    xcd_util_snapshot_t *snapshots;
+    size_t               i;
+
+    if(0 == size) return XCC_ERRNO_INVAL;
+
+    if(xcd_util_snapshots_num == xcd_util_snapshots_cap)
+    {
+        size_t cap = (0 == xcd_util_snapshots_cap ? 64 : xcd_util_snapshots_cap * 2);
+        if(NULL == (snapshots = xcd_arena_heap_realloc(xcd_util_snapshots, sizeof(xcd_util_snapshot_t) * cap))) return XCC_ERRNO_NOMEM;
+        xcd_util_snapshots = snapshots;
+        xcd_util_snapshots_cap = cap;
+    }
+
+    //insert (keep sorted)
+    for(i = xcd_util_snapshots_num; i > 0 && xcd_util_snapshots[i - 1].start > start; i--)
+        xcd_util_snapshots[i] = xcd_util_snapshots[i - 1];
+    xcd_util_snapshots[i].start = start;
+    xcd_util_snapshots[i].size = size;
+    xcd_util_snapshots[i].data = (const uint8_t *)data;
+    xcd_util_snapshots_num++;
+
+    return 0;
+}
+
+void xcd_util_set_snapshots_only(void)
+{
+    xcd_util_snapshots_only = 1;
+}
+
+//the ranges must be added in ascending order
+int xcd_util_add_readonly(uintptr_t start, uintptr_t end)
+{
+    xcd_util_readonly_t *readonlys;
+
+    if(start >= end) return XCC_ERRNO_INVAL;
+
+    if(xcd_util_readonlys_num > 0 && xcd_util_readonlys[xcd_util_readonlys_num - 1].end == start)
+    {
+        xcd_util_readonlys[xcd_util_readonlys_num - 1].end = end;
+        return 0;
+    }
+
+    if(xcd_util_readonlys_num == xcd_util_readonlys_cap)
+    {
+        size_t cap = (0 == xcd_util_readonlys_cap ? 64 : xcd_util_readonlys_cap * 2);
+        if(NULL == (readonlys = xcd_arena_heap_realloc(xcd_util_readonlys, sizeof(xcd_util_readonly_t) * cap))) return XCC_ERRNO_NOMEM;
+        xcd_util_readonlys = readonlys;
+        xcd_util_readonlys_cap = cap;
+    }
+    xcd_util_readonlys[xcd_util_readonlys_num].start = start;
+    xcd_util_readonlys[xcd_util_readonlys_num].end = end;
+    xcd_util_readonlys_num++;
+
+    return 0;
+}
+
+//return 1 if [addr, addr + size) is entirely inside a read-only mapping
+static int xcd_util_is_readonly(uintptr_t addr, size_t size)
+{
+    size_t lo = 0, hi = xcd_util_readonlys_num, mid;
+
+    if(0 == size) return 0;
+
+    //find the last range which start <= addr
+    while(lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if(xcd_util_readonlys[mid].start <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if(0 == lo) return 0;
+
+    return (addr < xcd_util_readonlys[lo - 1].end && size <= xcd_util_readonlys[lo - 1].end - addr) ? 1 : 0;
+}
+
+//return 1 if [addr, addr + size) is entirely inside a snapshot
+static int xcd_util_read_snapshot(uintptr_t addr, void *dst, size_t size)
+{
+    xcd_util_snapshot_t *snapshot;
+    size_t               lo = 0, hi = xcd_util_snapshots_num, mid;
+
+    if(0 == size) return 0;
+
+    //find the last snapshot which start <= addr
+    while(lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if(xcd_util_snapshots[mid].start <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if(0 == lo) return 0;
+    snapshot = &(xcd_util_snapshots[lo - 1]);
+
+    if(addr - snapshot->start > snapshot->size || size > snapshot->size - (addr - snapshot->start)) return 0;
+
+    memcpy(dst, snapshot->data + (addr - snapshot->start), size);
+    return 1;
+}
+
 size_t xcd_util_ptrace_read(pid_t pid, uintptr_t remote_addr, void *dst, size_t dst_len)
 {
     static size_t (*ptrace_read)(pid_t, uintptr_t, void *, size_t) = NULL;
 
+    if(xcd_util_read_snapshot(remote_addr, dst, dst_len)) return dst_len;
+    if(xcd_util_snapshots_only)
+    {
+        //the threads are not traced anymore, process_vm_readv() still works
+        return xcd_util_is_readonly(remote_addr, dst_len) ? xcd_util_process_vm_readv(pid, remote_addr, dst, dst_len) : 0;
+    }
+
     if(NULL != ptrace_read)
     {
         return ptrace_read(pid, remote_addr, dst, dst_len);
@@ -188,16 +333,131 @@ int xcd_util_ptrace_read_long(pid_t pid, uintptr_t addr, long *value)
     return 0;
 }
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+//read many small remote blocks with as few process_vm_readv calls as possible
+void xcd_util_remote_readv_batch(pid_t pid, xcd_util_remote_read_t *reqs, size_t reqs_count)
+{
+    size_t       page_size = (size_t)sysconf(_SC_PAGE_SIZE);
+    struct iovec local_iovs[IOV_MAX];
+    size_t       local_reqs[IOV_MAX]; //request index of each local iovec
+    struct iovec remote_iovs[IOV_MAX];
+    size_t       local_used, remote_used;
+    size_t       idx = 0; //current request
+    size_t       idx_offset = 0; //bytes of the current request already handled
+    size_t       i, len, got;
+    uintptr_t    addr, misalignment;
+    ssize_t      rc;
+
+    //requests which can be served by the local snapshots do not need a syscall
+    for(i = 0; i < reqs_count; i++)
+        reqs[i].bytes = (xcd_util_read_snapshot(reqs[i].addr, reqs[i].dst, reqs[i].len) ? reqs[i].len : 0);
+    if(xcd_util_snapshots_only)
+    {
+        for(i = 0; i < reqs_count; i++)
+            if(0 == reqs[i].bytes && xcd_util_is_readonly(reqs[i].addr, reqs[i].len))
+                reqs[i].bytes = xcd_util_process_vm_readv(pid, reqs[i].addr, reqs[i].dst, reqs[i].len);
+        return;
+    }
+
+    while(idx < reqs_count)
+    {
+        //build iovecs
+        local_used = 0;
+        remote_used = 0;
+        while(idx < reqs_count && local_used < IOV_MAX && remote_used < IOV_MAX)
+        {
+            if(idx_offset >= reqs[idx].len || reqs[idx].bytes >= reqs[idx].len)
+            {
+                idx++;
+                idx_offset = 0;
+                continue;
+            }
+
+            //the remote side (one page at a time, page boundaries aligned)
+            len = 0;
+            while(idx_offset + len < reqs[idx].len && remote_used < IOV_MAX)
+            {
+                if(__builtin_add_overflow(reqs[idx].addr, idx_offset + len, &addr)) break;
+                misalignment = addr & (page_size - 1);
+                remote_iovs[remote_used].iov_base = (void *)addr;
+                remote_iovs[remote_used].iov_len = page_size - misalignment;
+                if(remote_iovs[remote_used].iov_len > reqs[idx].len - idx_offset - len)
+                    remote_iovs[remote_used].iov_len = reqs[idx].len - idx_offset - len;
+                len += remote_iovs[remote_used].iov_len;
+                remote_used++;
+            }
+            if(0 == len)
+            {
+                //address overflow, skip this request
+                idx++;
+                idx_offset = 0;
+                continue;
+            }
+
+            //the local side
+            local_iovs[local_used].iov_base = (uint8_t *)reqs[idx].dst + idx_offset;
+            local_iovs[local_used].iov_len = len;
+            local_reqs[local_used] = idx;
+            local_used++;
+
+            idx_offset += len;
+            if(idx_offset >= reqs[idx].len)
+            {
+                idx++;
+                idx_offset = 0;
+            }
+        }
+        if(0 == local_used) break;
+
+        //read
+        if(NULL != process_vm_readv)
+            rc = process_vm_readv(pid, local_iovs, local_used, remote_iovs, remote_used, 0);
+        else
+            rc = syscall(__NR_process_vm_readv, pid, local_iovs, local_used, remote_iovs, remote_used, 0);
+        if(-1 == rc && EFAULT != errno)
+        {
+            //process_vm_readv is not available, read the rest one by one
+            for(i = local_reqs[0]; i < reqs_count; i++)
+            {
+                if(reqs[i].bytes >= reqs[i].len) continue;
+                reqs[i].bytes += xcd_util_ptrace_read(pid, reqs[i].addr + reqs[i].bytes,
+                                                      (uint8_t *)reqs[i].dst + reqs[i].bytes, reqs[i].len - reqs[i].bytes);
+            }
+            return;
+        }
+        if(rc < 0) rc = 0;
+
+        //save the results
+        for(i = 0; i < local_used; i++)
+        {
+            got = ((size_t)rc < local_iovs[i].iov_len ? (size_t)rc : local_iovs[i].iov_len);
+            reqs[local_reqs[i]].bytes += got;
+            rc -= (ssize_t)got;
+
+            if(got < local_iovs[i].iov_len)
+            {
+                //read failed in this request, skip the rest of it, continue with the next request
+                idx = local_reqs[i] + 1;
+                idx_offset = 0;
+                break;
+            }
+        }
+    }
+}
+
 static void* xcd_util_xz_alloc(ISzAllocPtr p, size_t size)
 {
     (void)p;
-    return malloc(size);
+    return xcd_arena_heap_malloc(size);
 }
 
 static void xcd_util_xz_free(ISzAllocPtr p, void* address)
 {
     (void)p;
-    free(address);
+    xcd_arena_heap_free(address);
 }
 
 static int xcd_util_xz_crc_gen = 0;
@@ -227,7 +487,7 @@ int xcd_util_xz_decompress(uint8_t* src, size_t src_size, uint8_t** dst, size_t*
     do
     {
         *dst_size *= 2;
-        if(NULL == (*dst = realloc(*dst, *dst_size)))
+        if(NULL == (*dst = xcd_arena_heap_realloc(*dst, *dst_size)))
         {
             XzUnpacker_Free(&state);
             return XCC_ERRNO_NOMEM;
@@ -239,7 +499,7 @@ int xcd_util_xz_decompress(uint8_t* src, size_t src_size, uint8_t** dst, size_t*
         if(SZ_OK != XzUnpacker_Code(&state, *dst + dst_offset, &dst_remaining,
                                     src + src_offset, &src_remaining, 1, CODER_FINISH_ANY, &status))
         {
-            free(*dst);
+            xcd_arena_heap_free(*dst);
             XzUnpacker_Free(&state);
             return XCC_ERRNO_FORMAT;
         }
@@ -251,12 +511,12 @@ int xcd_util_xz_decompress(uint8_t* src, size_t src_size, uint8_t** dst, size_t*
     
     if(!XzUnpacker_IsStreamWasFinished(&state))
     {
-        free(*dst);
+        xcd_arena_heap_free(*dst);
         return XCC_ERRNO_FORMAT;
     }
     
     *dst_size = dst_offset;
-    *dst = realloc(*dst, *dst_size);
+    *dst = xcd_arena_heap_realloc(*dst, *dst_size);
     
     return 0;
 }
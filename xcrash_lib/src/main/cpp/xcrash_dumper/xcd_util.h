@@ -33,9 +33,26 @@
 extern "C" {
 #endif
 
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    uintptr_t addr;  //remote address
+    void     *dst;
+    size_t    len;
+    size_t    bytes; //number of bytes read (output)
+} xcd_util_remote_read_t;
+#pragma clang diagnostic pop
+
 size_t xcd_util_ptrace_read(pid_t pid, uintptr_t addr, void *dst, size_t bytes);
 int xcd_util_ptrace_read_fully(pid_t pid, uintptr_t addr, void *dst, size_t bytes);
 int xcd_util_ptrace_read_long(pid_t pid, uintptr_t addr, long *value);
+void xcd_util_remote_readv_batch(pid_t pid, xcd_util_remote_read_t *reqs, size_t reqs_count);
+
+//remote reads entirely inside a snapshot are served from the local copy
+int xcd_util_add_snapshot(uintptr_t start, const void *data, size_t size);
+void xcd_util_set_snapshots_only(void); //refuse the other remote reads
+int xcd_util_add_readonly(uintptr_t start, uintptr_t end); //except the ones in the read-only mappings
 
 int xcd_util_xz_decompress(uint8_t* src, size_t src_size, uint8_t** dst, size_t* dst_size);
 
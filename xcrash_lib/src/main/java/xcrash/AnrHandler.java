@@ -209,6 +209,9 @@ class AnrHandler {
 
                 //write memory info
                 raf.write(Util.getMemoryInfo().getBytes("UTF-8"));
+
+                //cut the unused part of the placeholder file, so the file size is the content end
+                raf.setLength(raf.getFilePointer());
             } catch (Exception e) {
                 XCrash.getLogger().e(Util.TAG, "AnrHandler write log file failed", e);
             } finally {
@@ -83,6 +83,12 @@ class FileManager {
             int nativeLogCount = 0;
             int anrLogCount = 0;
             int traceLogCount = 0;
+            int nativeSnapshotLogCount = 0;
+            int nativeBinLogCount = 0;
+            int nativeSnapshotBinLogCount = 0;
+            int nativeRawLogCount = 0;
+            int nativeRawBinLogCount = 0;
+            int nativeRenderingLogCount = 0;
             int placeholderCleanCount = 0;
             int placeholderDirtyCount = 0;
             for (final File file : files) {
@@ -97,6 +103,18 @@ class FileManager {
                             anrLogCount++;
                         } else if (name.endsWith(Util.traceLogSuffix)) {
                             traceLogCount++;
+                        } else if (name.endsWith(Util.nativeSnapshotLogSuffix)) {
+                            nativeSnapshotLogCount++;
+                        } else if (name.endsWith(Util.nativeBinLogSuffix)) {
+                            nativeBinLogCount++;
+                        } else if (name.endsWith(Util.nativeSnapshotBinLogSuffix)) {
+                            nativeSnapshotBinLogCount++;
+                        } else if (name.endsWith(Util.nativeRawLogSuffix)) {
+                            nativeRawLogCount++;
+                        } else if (name.endsWith(Util.nativeRawBinLogSuffix)) {
+                            nativeRawBinLogCount++;
+                        } else if (name.endsWith(Util.nativeRenderingLogSuffix)) {
+                            nativeRenderingLogCount++;
                         }
                     } else if (name.startsWith(placeholderPrefix + "_")) {
                         if (name.endsWith(placeholderCleanSuffix)) {
@@ -112,6 +130,12 @@ class FileManager {
                 && nativeLogCount <= this.nativeLogCountMax
                 && anrLogCount <= this.anrLogCountMax
                 && traceLogCount <= this.traceLogCountMax
+                && nativeSnapshotLogCount <= this.nativeLogCountMax
+                && nativeBinLogCount <= this.nativeLogCountMax
+                && nativeSnapshotBinLogCount <= this.nativeLogCountMax
+                && nativeRawLogCount <= this.nativeLogCountMax
+                && nativeRawBinLogCount <= this.nativeLogCountMax
+                && nativeRenderingLogCount <= this.nativeLogCountMax
                 && placeholderCleanCount == this.placeholderCountMax
                 && placeholderDirtyCount == 0) {
                 //everything OK, need to do nothing
@@ -120,6 +144,9 @@ class FileManager {
                 || nativeLogCount > this.nativeLogCountMax + 10
                 || anrLogCount > this.anrLogCountMax + 10
                 || traceLogCount > this.traceLogCountMax + 10
+                || nativeSnapshotLogCount > this.nativeLogCountMax + 10
+                || nativeBinLogCount > this.nativeLogCountMax + 10
+                || nativeSnapshotBinLogCount > this.nativeLogCountMax + 10
                 || placeholderCleanCount > this.placeholderCountMax + 10
                 || placeholderDirtyCount > 10) {
                 //too many unwanted files, clean up now
@@ -129,6 +156,9 @@ class FileManager {
                 || nativeLogCount > this.nativeLogCountMax
                 || anrLogCount > this.anrLogCountMax
                 || traceLogCount > this.traceLogCountMax
+                || nativeSnapshotLogCount > this.nativeLogCountMax
+                || nativeBinLogCount > this.nativeLogCountMax
+                || nativeSnapshotBinLogCount > this.nativeLogCountMax
                 || placeholderCleanCount > this.placeholderCountMax
                 || placeholderDirtyCount > 0) {
                 //have some unwanted files, clean up as soon as possible
@@ -168,6 +198,30 @@ class FileManager {
         }
     }
 
+    void maintainPlaceholder() {
+        if (this.logDir == null || this.placeholderCountMax <= 0) {
+            return;
+        }
+
+        try {
+            new Thread(new Runnable() {
+                @Override
+                public void run() {
+                    if (!Util.checkAndCreateDir(logDir)) {
+                        return;
+                    }
+                    try {
+                        doMaintainPlaceholder(new File(logDir));
+                    } catch (Exception e) {
+                        XCrash.getLogger().e(Util.TAG, "FileManager doMaintainPlaceholder failed", e);
+                    }
+                }
+            }, "xcrash_file_mgr").start();
+        } catch (Exception e) {
+            XCrash.getLogger().e(Util.TAG, "FileManager maintainPlaceholder start failed", e);
+        }
+    }
+
     boolean maintainAnr() {
         if (!Util.checkAndCreateDir(logDir)) {
             return false;
@@ -237,10 +291,18 @@ class FileManager {
     boolean appendText(String logPath, String text) {
         RandomAccessFile raf = null;
 
+        //never create it, the log file may have been renamed or removed
+        if (!new File(logPath).exists()) {
+            XCrash.getLogger().w(Util.TAG, "FileManager appendText failed, file does not exist: " + logPath);
+            return false;
+        }
+
         try {
             raf = new RandomAccessFile(logPath, "rws");
 
             //get the write position
+            //(the logs written by xCrash end at the file size, the backward scan stops at once,
+            //it only walks the trailing zeros of a placeholder file which has not been cut)
             long pos = 0;
             if (raf.length() > 0) {
                 FileChannel fc = raf.getChannel();
@@ -255,6 +317,7 @@ class FileManager {
             //write text
             raf.seek(pos);
             raf.write(text.getBytes("UTF-8"));
+            raf.setLength(raf.getFilePointer());
 
             return true;
         } catch (Exception e) {
@@ -347,6 +410,12 @@ class FileManager {
         doMaintainTombstoneType(dir, Util.javaLogSuffix, javaLogCountMax);
         doMaintainTombstoneType(dir, Util.anrLogSuffix, anrLogCountMax);
         doMaintainTombstoneType(dir, Util.traceLogSuffix, traceLogCountMax);
+        doMaintainTombstoneType(dir, Util.nativeSnapshotLogSuffix, nativeLogCountMax);
+        doMaintainTombstoneType(dir, Util.nativeBinLogSuffix, nativeLogCountMax);
+        doMaintainTombstoneType(dir, Util.nativeSnapshotBinLogSuffix, nativeLogCountMax);
+        doMaintainTombstoneType(dir, Util.nativeRawLogSuffix, nativeLogCountMax);
+        doMaintainTombstoneType(dir, Util.nativeRawBinLogSuffix, nativeLogCountMax);
+        doMaintainTombstoneType(dir, Util.nativeRenderingLogSuffix, nativeLogCountMax);
     }
 
     private boolean doMaintainTombstoneType(File dir, final String logSuffix, int logCountMax) {
@@ -456,6 +525,9 @@ class FileManager {
                 dirtyFile.delete();
             }
         }
+
+        //keep some opened placeholder files in the native layer for the signal handler
+        NativeHandler.getInstance().fillPlaceholderPool();
     }
 
     @SuppressWarnings("ResultOfMethodCallIgnored")
@@ -465,29 +537,33 @@ class FileManager {
         boolean succeeded = false;
 
         try {
-            byte[] block = new byte[1024];
-            Arrays.fill(block, (byte) 0);
-
-            long blockCount = placeholderSizeKb;
-            long dirtyFileSize = dirtyFile.length();
-            if (dirtyFileSize > placeholderSizeKb * 1024) {
-                blockCount = dirtyFileSize / 1024;
-                if (dirtyFileSize % 1024 != 0) {
-                    blockCount++;
+            //allocate zero-filled blocks in the native layer (metadata operations only),
+            //or clean the dirty file by writing zeros
+            if (!NativeHandler.getInstance().provisionPlaceholder(dirtyFile.getAbsolutePath(), (long) placeholderSizeKb * 1024)) {
+                byte[] block = new byte[1024];
+                Arrays.fill(block, (byte) 0);
+
+                long blockCount = placeholderSizeKb;
+                long dirtyFileSize = dirtyFile.length();
+                if (dirtyFileSize > placeholderSizeKb * 1024) {
+                    blockCount = dirtyFileSize / 1024;
+                    if (dirtyFileSize % 1024 != 0) {
+                        blockCount++;
+                    }
                 }
-            }
 
-            //clean the dirty file
-            stream = new FileOutputStream(dirtyFile.getAbsoluteFile(), false);
-            for (int i = 0; i < blockCount; i++) {
-                if (i + 1 == blockCount && dirtyFileSize % 1024 != 0) {
-                    //the last block
-                    stream.write(block, 0, (int) (dirtyFileSize % 1024));
-                } else {
-                    stream.write(block);
+                //clean the dirty file
+                stream = new FileOutputStream(dirtyFile.getAbsoluteFile(), false);
+                for (int i = 0; i < blockCount; i++) {
+                    if (i + 1 == blockCount && dirtyFileSize % 1024 != 0) {
+                        //the last block
+                        stream.write(block, 0, (int) (dirtyFileSize % 1024));
+                    } else {
+                        stream.write(block);
+                    }
                 }
+                stream.flush();
             }
-            stream.flush();
 
             //rename the dirty file to clean file
             String newCleanFilePath = String.format(Locale.US, "%s/%s_%020d%s", logDir, placeholderPrefix, new Date().getTime() * 1000 + getNextUnique(), placeholderCleanSuffix);
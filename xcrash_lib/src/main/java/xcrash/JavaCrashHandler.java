@@ -183,6 +183,9 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
                 if (dumpAllThreads) {
                     raf.write(getOtherThreadsInfo(thread).getBytes("UTF-8"));
                 }
+
+                //cut the unused part of the placeholder file, so the file size is the content end
+                raf.setLength(raf.getFilePointer());
             } catch (Exception e) {
                 XCrash.getLogger().e(Util.TAG, "JavaCrashHandler write log file failed", e);
             } finally {
@@ -29,6 +29,10 @@ import android.os.Build;
 import android.text.TextUtils;
 
 import java.io.File;
+import java.io.FilenameFilter;
+import java.io.InputStream;
+import java.util.ArrayList;
+import java.util.List;
 import java.util.Map;
 
 @SuppressLint("StaticFieldLeak")
@@ -36,9 +40,15 @@ class NativeHandler {
 
     private static final NativeHandler instance = new NativeHandler();
     private long anrTimeoutMs = 15 * 1000;
+    private long renderPendingMs = 2 * 60 * 1000;
+    private long renderStaleMs = 5 * 60 * 1000;
+    private long renderTimeoutMs = 60 * 1000;
 
     private Context ctx;
+    private String logDir;
+    private boolean crashEnable;
     private boolean crashRethrow;
+    private boolean crashDumpElfHash;
     private ICrashCallback crashCallback;
     private boolean anrEnable;
     private boolean anrCheckProcessState;
@@ -70,6 +80,9 @@ class NativeHandler {
                    boolean crashDumpAllThreads,
                    int crashDumpAllThreadsCountMax,
                    String[] crashDumpAllThreadsAllowList,
+                   boolean crashDumpBinary,
+                   boolean crashStandbyDumper,
+                   boolean crashDeferSymbols,
                    ICrashCallback crashCallback,
                    boolean anrEnable,
                    boolean anrRethrow,
@@ -98,7 +111,10 @@ class NativeHandler {
         }
 
         this.ctx = ctx;
+        this.logDir = logDir;
+        this.crashEnable = crashEnable;
         this.crashRethrow = crashRethrow;
+        this.crashDumpElfHash = crashDumpElfHash;
         this.crashCallback = crashCallback;
         this.anrEnable = anrEnable;
         this.anrCheckProcessState = anrCheckProcessState;
@@ -131,6 +147,9 @@ class NativeHandler {
                 crashDumpAllThreads,
                 crashDumpAllThreadsCountMax,
                 crashDumpAllThreadsAllowList,
+                crashDumpBinary,
+                crashStandbyDumper,
+                crashDeferSymbols,
                 anrEnable,
                 anrRethrow,
                 anrLogcatSystemLines,
@@ -162,6 +181,173 @@ class NativeHandler {
         }
     }
 
+    String dumpNativeSnapshot() {
+        if (initNativeLibOk) {
+            String logPath = NativeHandler.nativeDumpSnapshot();
+
+            //a placeholder file may have been taken from the pool
+            FileManager.getInstance().maintainPlaceholder();
+            return logPath;
+        }
+        return null;
+    }
+
+    void fillPlaceholderPool() {
+        if (initNativeLibOk) {
+            NativeHandler.nativeFillPlaceholderPool();
+        }
+    }
+
+    boolean provisionPlaceholder(String path, long size) {
+        if (initNativeLibOk) {
+            return NativeHandler.nativeProvisionPlaceholder(path, size);
+        }
+        return false;
+    }
+
+    void renderRawTombstones() {
+        if (!initNativeLibOk || !crashEnable) {
+            return;
+        }
+
+        try {
+            new Thread(new Runnable() {
+                @Override
+                public void run() {
+                    try {
+                        doRenderRawTombstones();
+                    } catch (Exception e) {
+                        XCrash.getLogger().e(Util.TAG, "NativeHandler doRenderRawTombstones failed", e);
+                    }
+                }
+            }, "xcrash_symbolizer").start();
+        } catch (Exception e) {
+            XCrash.getLogger().e(Util.TAG, "NativeHandler renderRawTombstones start failed", e);
+        }
+    }
+
+    private void doRenderRawTombstones() {
+        //raw tombstones of all the processes, each one is claimed by renaming it before rendering,
+        //so that only one process renders it, even if several processes are started at the same time
+        File[] files = new File(logDir).listFiles(new FilenameFilter() {
+            @Override
+            public boolean accept(File dir, String name) {
+                return name.startsWith(Util.logPrefix + "_")
+                    && (name.endsWith(Util.nativeRawLogSuffix) || name.endsWith(Util.nativeRenderingLogSuffix));
+            }
+        });
+        if (files == null) {
+            return;
+        }
+
+        for (File file : files) {
+            String path = file.getAbsolutePath();
+            boolean claimed = path.endsWith(Util.nativeRenderingLogSuffix);
+            String pathPrefix = path.substring(0, path.length()
+                - (claimed ? Util.nativeRenderingLogSuffix.length() : Util.nativeRawLogSuffix.length()));
+            String logPath = pathPrefix + Util.nativeLogSuffix;
+            File logFile = new File(logPath);
+            File renderingFile = new File(pathPrefix + Util.nativeRenderingLogSuffix);
+
+            if (claimed) {
+                //being rendered by another process, or that process died while rendering it
+                if (System.currentTimeMillis() - file.lastModified() < renderStaleMs) {
+                    continue;
+                }
+
+                //keep the raw tombstone without the function names
+                //(rename replaces the partial output, and only one process wins it)
+                if (!renderingFile.renameTo(logFile)) {
+                    continue;
+                }
+            } else {
+                //the crashed process may be still writing it (the dumper runs up to 30 seconds,
+                //then the java callback appends its sections), render it on a later launch
+                if (System.currentTimeMillis() - file.lastModified() < renderPendingMs) {
+                    continue;
+                }
+
+                //claim it, another process may have claimed it already
+                if (!file.renameTo(renderingFile)) {
+                    continue;
+                }
+                //renaming keeps the crash time, the claiming time is used to detect the stale claims
+                renderingFile.setLastModified(System.currentTimeMillis());
+
+                if (renderRawTombstone(renderingFile.getAbsolutePath(), logPath)) {
+                    FileManager.getInstance().recycleLogFile(renderingFile);
+                } else {
+                    //keep the raw tombstone without the function names
+                    if (!renderingFile.renameTo(logFile)) {
+                        continue;
+                    }
+                }
+            }
+
+            //the binary tombstone has no function names either way
+            File rawBinFile = new File(pathPrefix + Util.nativeRawBinLogSuffix);
+            if (rawBinFile.exists() && !rawBinFile.renameTo(new File(pathPrefix + Util.nativeBinLogSuffix))) {
+                FileManager.getInstance().recycleLogFile(rawBinFile);
+            }
+
+            ICrashCallback callback = crashCallback;
+            if (callback != null) {
+                try {
+                    callback.onCrash(logPath, null);
+                } catch (Exception e) {
+                    XCrash.getLogger().w(Util.TAG, "NativeHandler native crash callback.onCrash failed", e);
+                }
+            }
+        }
+    }
+
+    //symbolize with the on-disk libraries: libxcrash_dumper.so --symbolize <raw> <tombstone> [--elf-hash]
+    private boolean renderRawTombstone(String rawPath, String logPath) {
+        List<String> command = new ArrayList<String>();
+        command.add(ctx.getApplicationInfo().nativeLibraryDir + "/libxcrash_dumper.so");
+        command.add("--symbolize");
+        command.add(rawPath);
+        command.add(logPath);
+        if (crashDumpElfHash) {
+            command.add("--elf-hash");
+        }
+
+        Process process = null;
+        try {
+            process = new ProcessBuilder().command(command).redirectErrorStream(true).start();
+            process.getOutputStream().close();
+
+            //discard the output, so that the symbolizer never blocks on a full pipe
+            InputStream output = process.getInputStream();
+            byte[] buf = new byte[1024];
+            long deadline = System.currentTimeMillis() + renderTimeoutMs;
+            while (true) {
+                while (output.available() > 0) {
+                    if (output.read(buf) < 0) {
+                        break;
+                    }
+                }
+                try {
+                    return process.exitValue() == 0;
+                } catch (IllegalThreadStateException ignored) {
+                    //still running
+                }
+                if (System.currentTimeMillis() > deadline) {
+                    XCrash.getLogger().w(Util.TAG, "NativeHandler run symbolizer timeout");
+                    return false;
+                }
+                Thread.sleep(50);
+            }
+        } catch (Exception e) {
+            XCrash.getLogger().w(Util.TAG, "NativeHandler run symbolizer failed", e);
+            return false;
+        } finally {
+            if (process != null) {
+                process.destroy();
+            }
+        }
+    }
+
     private static String getStacktraceByThreadName(boolean isMainThread, String threadName) {
         try {
             for (Map.Entry<Thread, StackTraceElement[]> entry : Thread.getAllStackTraces().entrySet()) {
@@ -201,8 +387,9 @@ class NativeHandler {
             TombstoneManager.appendSection(logPath, "foreground", ActivityMonitor.getInstance().isApplicationForeground() ? "yes" : "no");
         }
 
+        //the callback receives the final tombstone once it is rendered on the next launch
         ICrashCallback callback = NativeHandler.getInstance().crashCallback;
-        if (callback != null) {
+        if (callback != null && (logPath == null || !logPath.endsWith(Util.nativeRawLogSuffix))) {
             try {
                 callback.onCrash(logPath, emergency);
             } catch (Exception e) {
@@ -218,6 +405,9 @@ class NativeHandler {
     // do NOT obfuscate this method
     @SuppressWarnings("unused")
     private static void traceCallback(String logPath, String emergency) {
+        //a placeholder file may have been taken from the pool
+        FileManager.getInstance().maintainPlaceholder();
+
         if (TextUtils.isEmpty(logPath)) {
             return;
         }
@@ -284,6 +474,9 @@ class NativeHandler {
             boolean crashDumpAllThreads,
             int crashDumpAllThreadsCountMax,
             String[] crashDumpAllThreadsAllowList,
+            boolean crashDumpBinary,
+            boolean crashStandbyDumper,
+            boolean crashDeferSymbols,
             boolean traceEnable,
             boolean traceRethrow,
             int traceLogcatSystemLines,
@@ -295,4 +488,10 @@ class NativeHandler {
     private static native void nativeNotifyJavaCrashed();
 
     private static native void nativeTestCrash(int runInNewThread);
+
+    private static native String nativeDumpSnapshot();
+
+    private static native void nativeFillPlaceholderPool();
+
+    private static native boolean nativeProvisionPlaceholder(String path, long size);
 }
@@ -0,0 +1,432 @@
+// Copyright (c) 2020-present, HexHacking Team. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+package xcrash;
+
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.nio.charset.Charset;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Locale;
+
+/**
+ * Decoder for the binary tombstone (*.xcbin) written when {@link XCrash.InitParameters#setNativeDumpBinary(boolean)} is enabled.
+ *
+ * <p>The decoder renders the header, threads, backtraces, build-ids and the memory map in the text tombstone layout,
+ * so the result can be parsed by {@link TombstoneParser#parse(String, String)} as the emergency buffer (with a null log path).
+ */
+@SuppressWarnings("unused")
+public class TombstoneDecoder {
+
+    private static final int VERSION = 1;
+
+    private static final int REC_HEADER_ITEM = 1;
+    private static final int REC_MAP = 2;
+    private static final int REC_THREAD = 3;
+    private static final int REC_FRAME = 4;
+    private static final int REC_BUILD_ID = 5;
+    private static final int REC_END = 6;
+    private static final int REC_LOAD_BIAS = 7;
+
+    private static final int MAP_FLAG_READ = 0x1;
+    private static final int MAP_FLAG_WRITE = 0x2;
+    private static final int MAP_FLAG_EXEC = 0x4;
+    private static final int MAP_FLAG_SAME_NAME = 0x8;
+
+    private static final Charset UTF8 = Charset.forName("UTF-8");
+
+    private TombstoneDecoder() {
+    }
+
+    /**
+     * Render the binary tombstone file in the text tombstone layout.
+     *
+     * @param binPath The path of the binary tombstone file.
+     * @return The text, or null if the file can not be read or is not a binary tombstone.
+     */
+    public static String decode(String binPath) {
+        byte[] data;
+        try {
+            data = readFile(new File(binPath));
+        } catch (Exception e) {
+            XCrash.getLogger().w(Util.TAG, "TombstoneDecoder read file failed", e);
+            return null;
+        }
+        return decode(data);
+    }
+
+    /**
+     * Render the binary tombstone data in the text tombstone layout.
+     *
+     * @param data The content of the binary tombstone file.
+     * @return The text, or null if the data is not a binary tombstone.
+     */
+    public static String decode(byte[] data) {
+        if (data == null || data.length < 6
+            || data[0] != 'X' || data[1] != 'C' || data[2] != 'B' || data[3] != 'T'
+            || data[4] != VERSION || (data[5] != 4 && data[5] != 8)) {
+            return null;
+        }
+        return new Decoder(data, data[5] * 2).render();
+    }
+
+    private static byte[] readFile(File file) throws IOException {
+        FileInputStream in = new FileInputStream(file);
+        try {
+            byte[] data = new byte[(int) file.length()];
+            int offset = 0;
+            while (offset < data.length) {
+                int n = in.read(data, offset, data.length - offset);
+                if (n < 0) {
+                    break;
+                }
+                offset += n;
+            }
+            return data;
+        } finally {
+            in.close();
+        }
+    }
+
+    private static class Reader {
+        private final byte[] data;
+        private int pos;
+        private final int end;
+
+        Reader(byte[] data, int pos, int end) {
+            this.data = data;
+            this.pos = pos;
+            this.end = end;
+        }
+
+        boolean hasMore() {
+            return pos < end;
+        }
+
+        long getUleb128() {
+            long value = 0;
+            int shift = 0;
+            int b;
+            do {
+                if (pos >= end || shift >= 64) {
+                    throw new IllegalStateException("truncated");
+                }
+                b = data[pos++] & 0xff;
+                value |= ((long) (b & 0x7f)) << shift;
+                shift += 7;
+            } while ((b & 0x80) != 0);
+            return value;
+        }
+
+        byte[] getBytes() {
+            long len = getUleb128();
+            if (len > end - pos) {
+                throw new IllegalStateException("truncated");
+            }
+            byte[] bytes = new byte[(int) len];
+            System.arraycopy(data, pos, bytes, 0, (int) len);
+            pos += (int) len;
+            return bytes;
+        }
+
+        String getString() {
+            return new String(getBytes(), UTF8);
+        }
+
+        Reader getRecord(int len) {
+            if (len < 0 || len > end - pos) {
+                throw new IllegalStateException("truncated");
+            }
+            Reader r = new Reader(data, pos, pos + len);
+            pos += len;
+            return r;
+        }
+    }
+
+    private static class MapInfo {
+        long start;
+        long end;
+        long offset;
+        long flags;
+        long elfStartOffset;
+        long loadBias;
+        String name;
+    }
+
+    private static class Decoder {
+        private final byte[] data;
+        private final int addrWidth;
+        private final List<MapInfo> maps = new ArrayList<MapInfo>();
+        private final StringBuilder sb = new StringBuilder();
+        private boolean inThread = false;
+        private boolean inCrashedThread = false;
+        private boolean inBacktrace = false;
+        private boolean inBuildId = false;
+        private int otherThreads = 0;
+
+        Decoder(byte[] data, int addrWidth) {
+            this.data = data;
+            this.addrWidth = addrWidth;
+        }
+
+        String render() {
+            //the map table and the load biases are needed by the frames and the memory map
+            loadMaps();
+
+            boolean header = false;
+            boolean completed = false;
+            Reader reader = new Reader(data, 6, data.length);
+            try {
+                while (reader.hasMore()) {
+                    int type = (int) reader.getUleb128();
+                    Reader payload = reader.getRecord((int) reader.getUleb128());
+                    switch (type) {
+                        case REC_HEADER_ITEM:
+                            if (!header) {
+                                sb.append(Util.sepHead).append('\n');
+                                header = true;
+                            }
+                            String key = payload.getString();
+                            sb.append(key).append(": '").append(payload.getString()).append("'\n");
+                            break;
+                        case REC_THREAD:
+                            endThread();
+                            long pid = payload.getUleb128();
+                            long tid = payload.getUleb128();
+                            boolean crashed = payload.getUleb128() != 0;
+                            String tname = payload.getString();
+                            String pname = payload.getString();
+                            if (!crashed) {
+                                sb.append(Util.sepOtherThreads).append('\n');
+                                otherThreads++;
+                            }
+                            sb.append("pid: ").append(pid).append(", tid: ").append(tid).append(", name: ").append(tname)
+                                .append("  >>> ").append(pname).append(" <<<\n");
+                            inThread = true;
+                            inCrashedThread = crashed;
+                            break;
+                        case REC_FRAME:
+                            if (inThread) {
+                                renderFrame(payload);
+                            }
+                            break;
+                        case REC_BUILD_ID:
+                            if (inThread) {
+                                renderBuildId(payload);
+                            }
+                            break;
+                        case REC_END:
+                            completed = true;
+                            break;
+                        default:
+                            //unknown record from a newer version, skip it
+                            break;
+                    }
+                }
+            } catch (IllegalStateException ignored) {
+                //truncated file, render what we have
+            }
+            endThread();
+
+            if (otherThreads > 0) {
+                sb.append(Util.sepOtherThreads).append('\n');
+                sb.append("dumped threads: ").append(otherThreads).append('\n');
+                sb.append(Util.sepOtherThreadsEnding).append('\n');
+            }
+            if (!completed) {
+                sb.append("\n\nxcrash error debug:\nbinary tombstone is incomplete\n\n");
+            }
+            return sb.toString();
+        }
+
+        private void loadMaps() {
+            Reader reader = new Reader(data, 6, data.length);
+            MapInfo prev = null;
+            try {
+                while (reader.hasMore()) {
+                    int type = (int) reader.getUleb128();
+                    Reader payload = reader.getRecord((int) reader.getUleb128());
+                    if (type == REC_LOAD_BIAS) {
+                        //the LOAD_BIAS records follow the map table
+                        MapInfo map = getMap(payload.getUleb128());
+                        long loadBias = payload.getUleb128();
+                        if (map != null) {
+                            map.loadBias = loadBias;
+                        }
+                        continue;
+                    }
+                    if (type != REC_MAP) {
+                        continue;
+                    }
+                    MapInfo map = new MapInfo();
+                    map.start = payload.getUleb128();
+                    map.end = payload.getUleb128();
+                    map.offset = payload.getUleb128();
+                    map.flags = payload.getUleb128();
+                    map.elfStartOffset = payload.getUleb128();
+                    map.loadBias = payload.getUleb128();
+                    map.name = payload.getString();
+                    if ((map.flags & MAP_FLAG_SAME_NAME) != 0 && prev != null) {
+                        map.name = prev.name;
+                    }
+                    maps.add(map);
+                    prev = map;
+                }
+            } catch (IllegalStateException ignored) {
+                //truncated file
+            }
+        }
+
+        private MapInfo getMap(long index) {
+            return (index == 0 || index > maps.size()) ? null : maps.get((int) (index - 1));
+        }
+
+        private String hex(long value, int width) {
+            String s = Long.toHexString(value);
+            StringBuilder r = new StringBuilder();
+            for (int i = s.length(); i < width; i++) {
+                r.append('0');
+            }
+            return r.append(s).toString();
+        }
+
+        private String pad(String s, int width) {
+            StringBuilder r = new StringBuilder();
+            for (int i = s.length(); i < width; i++) {
+                r.append(' ');
+            }
+            return r.append(s).toString();
+        }
+
+        private void endThread() {
+            if (inBacktrace) {
+                sb.append('\n');
+            }
+            if (inBuildId) {
+                sb.append('\n');
+            }
+            if (inCrashedThread && maps.size() > 0) {
+                renderMaps();
+            }
+            inThread = false;
+            inCrashedThread = false;
+            inBacktrace = false;
+            inBuildId = false;
+        }
+
+        private void renderFrame(Reader payload) {
+            if (!inBacktrace) {
+                sb.append("backtrace:\n");
+                inBacktrace = true;
+            }
+
+            long num = payload.getUleb128();
+            payload.getUleb128(); //absolute pc
+            long relPc = payload.getUleb128();
+            MapInfo map = getMap(payload.getUleb128());
+            long funcOffset = payload.getUleb128();
+            String funcName = payload.getString();
+            String soName = payload.getString();
+
+            String name;
+            if (map == null) {
+                name = "<unknown>";
+            } else if (map.name.isEmpty()) {
+                name = "<anonymous:" + hex(map.start, addrWidth) + ">";
+            } else if (map.elfStartOffset != 0 && !soName.isEmpty()) {
+                name = map.name + "!" + soName;
+            } else {
+                name = map.name;
+            }
+
+            sb.append(String.format(Locale.US, "    #%02d pc ", num)).append(hex(relPc, addrWidth)).append("  ").append(name);
+            if (map != null && map.elfStartOffset != 0) {
+                sb.append(" (offset 0x").append(Long.toHexString(map.elfStartOffset)).append(')');
+            }
+            if (!funcName.isEmpty()) {
+                sb.append(" (").append(funcName);
+                if (funcOffset > 0) {
+                    sb.append('+').append(funcOffset);
+                }
+                sb.append(')');
+            }
+            sb.append('\n');
+        }
+
+        private void renderBuildId(Reader payload) {
+            if (inBacktrace) {
+                sb.append('\n');
+                inBacktrace = false;
+            }
+            if (!inBuildId) {
+                sb.append("build id:\n");
+                inBuildId = true;
+            }
+
+            MapInfo map = getMap(payload.getUleb128());
+            byte[] buildId = payload.getBytes();
+            String detail = payload.getString();
+            if (map == null) {
+                return;
+            }
+
+            sb.append("    ").append(map.name).append(" (BuildId: ");
+            if (buildId.length == 0) {
+                sb.append("unknown");
+            } else {
+                for (byte b : buildId) {
+                    sb.append(String.format(Locale.US, "%02x", b & 0xff));
+                }
+            }
+            sb.append(detail).append('\n');
+        }
+
+        private void renderMaps() {
+            long maxSize = 0, maxOffset = 0, totalSize = 0;
+            for (MapInfo map : maps) {
+                maxSize = Math.max(maxSize, map.end - map.start);
+                maxOffset = Math.max(maxOffset, map.offset);
+            }
+            int widthSize = Math.max(1, Long.toHexString(maxSize).length());
+            int widthOffset = Math.max(1, Long.toHexString(maxOffset).length());
+
+            sb.append("memory map:\n");
+            for (MapInfo map : maps) {
+                long size = map.end - map.start;
+                totalSize += size;
+                sb.append("    ").append(hex(map.start, addrWidth)).append('-').append(hex(map.end, addrWidth)).append(' ')
+                    .append((map.flags & MAP_FLAG_READ) != 0 ? 'r' : '-')
+                    .append((map.flags & MAP_FLAG_WRITE) != 0 ? 'w' : '-')
+                    .append((map.flags & MAP_FLAG_EXEC) != 0 ? 'x' : '-').append(' ')
+                    .append(pad(Long.toHexString(map.offset), widthOffset)).append(' ')
+                    .append(pad(Long.toHexString(size), widthSize)).append(' ')
+                    .append(((map.flags & MAP_FLAG_SAME_NAME) != 0 && map.loadBias == 0) ? ">" : map.name);
+                if (map.loadBias != 0) {
+                    sb.append(" (load bias 0x").append(Long.toHexString(map.loadBias)).append(')');
+                }
+                sb.append('\n');
+            }
+            sb.append("    TOTAL SIZE: 0x").append(Long.toHexString(totalSize / 1024)).append("K (").append(totalSize / 1024).append("K)\n\n");
+        }
+    }
+}
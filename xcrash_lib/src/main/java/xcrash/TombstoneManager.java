@@ -178,7 +178,7 @@ public class TombstoneManager {
      */
     @SuppressWarnings("unused")
     public static boolean clearNativeTombstones() {
-        return clearTombstones(new String[]{Util.nativeLogSuffix});
+        return clearTombstones(new String[]{Util.nativeLogSuffix, Util.nativeBinLogSuffix, Util.nativeRawLogSuffix, Util.nativeRawBinLogSuffix, Util.nativeRenderingLogSuffix});
     }
 
     /**
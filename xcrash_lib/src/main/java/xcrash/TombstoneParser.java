@@ -452,6 +452,11 @@ public class TombstoneParser {
                     map.put(keyCrashType, Util.anrCrashType);
                 }
                 filename = filename.substring(0, filename.length() - Util.anrLogSuffix.length());
+            } else if (filename.endsWith(Util.nativeSnapshotLogSuffix)) {
+                if (TextUtils.isEmpty(crashType)) {
+                    map.put(keyCrashType, Util.nativeSnapshotCrashType);
+                }
+                filename = filename.substring(0, filename.length() - Util.nativeSnapshotLogSuffix.length());
             } else {
                 return;
             }
@@ -61,11 +61,18 @@ class Util {
 
     static final String javaCrashType = "java";
     static final String nativeCrashType = "native";
+    static final String nativeSnapshotCrashType = "native-snapshot";
     static final String anrCrashType = "anr";
 
     static final String logPrefix = "tombstone";
     static final String javaLogSuffix = ".java.xcrash";
     static final String nativeLogSuffix = ".native.xcrash";
+    static final String nativeSnapshotLogSuffix = ".native-snapshot.xcrash";
+    static final String nativeBinLogSuffix = ".native.xcbin";
+    static final String nativeSnapshotBinLogSuffix = ".native-snapshot.xcbin";
+    static final String nativeRawLogSuffix = ".native-raw.xcrash";
+    static final String nativeRawBinLogSuffix = ".native-raw.xcbin";
+    static final String nativeRenderingLogSuffix = ".native-raw.rendering";
     static final String anrLogSuffix = ".anr.xcrash";
     static final String traceLogSuffix = ".trace.xcrash";
 
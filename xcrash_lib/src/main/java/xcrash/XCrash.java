@@ -200,6 +200,9 @@ public final class XCrash {
                 params.nativeDumpAllThreads,
                 params.nativeDumpAllThreadsCountMax,
                 params.nativeDumpAllThreadsAllowList,
+                params.nativeDumpBinary,
+                params.nativeStandbyDumper,
+                params.nativeDeferSymbols,
                 params.nativeCallback,
                 params.enableAnrHandler && Build.VERSION.SDK_INT >= 21,
                 params.anrRethrow,
@@ -212,6 +215,9 @@ public final class XCrash {
                 params.anrCallback);
         }
 
+        //render the raw tombstones of the previous native crashes in a background thread
+        NativeHandler.getInstance().renderRawTombstones();
+
         //maintain tombstone and placeholder files in a background thread with some delay
         FileManager.getInstance().maintain();
 
@@ -510,6 +516,9 @@ public final class XCrash {
         boolean        nativeDumpAllThreads          = true;
         int            nativeDumpAllThreadsCountMax  = 0;
         String[]       nativeDumpAllThreadsAllowList = null;
+        boolean        nativeDumpBinary              = false;
+        boolean        nativeStandbyDumper           = false;
+        boolean        nativeDeferSymbols            = false;
         ICrashCallback nativeCallback                = null;
 
         /**
@@ -690,6 +699,58 @@ public final class XCrash {
             return this;
         }
 
+        /**
+         * Set if writing a compact binary tombstone (*.xcbin) alongside the text tombstone when a native crash occurred. (Default: disable)
+         *
+         * <p>The binary tombstone contains the header items, threads, backtraces (numeric PCs and map indexes),
+         * build-ids and the memory map table. Use {@link TombstoneDecoder#decode(String)} to render it in the text layout.
+         *
+         * @param flag True or false.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeDumpBinary(boolean flag) {
+            this.nativeDumpBinary = flag;
+            return this;
+        }
+
+        /**
+         * Set if spawning the native crash dumper process in advance. (Default: disable)
+         *
+         * <p>The standby dumper is spawned when xCrash is initialized, and waits for a native crash.
+         * It saves the fork and exec at crash time, so the tombstone is written sooner.
+         * If the standby dumper is gone when a native crash occurred, a new one will be spawned as usual.
+         *
+         * @param flag True or false.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeStandbyDumper(boolean flag) {
+            this.nativeStandbyDumper = flag;
+            return this;
+        }
+
+        /**
+         * Set if deferring the symbolization of native crashes to the next launch. (Default: disable)
+         *
+         * <p>When a native crash occurred, the dumper writes a raw tombstone (*.native-raw.xcrash) without
+         * the function names and the ELF hashes. It is rendered into the final tombstone against the on-disk
+         * libraries when xCrash is initialized next time (and at least 2 minutes after the crash, so that the
+         * crashed process has finished writing it), then the native crash callback is executed with the
+         * final tombstone path. Frames in the libraries updated since the crash are left unsymbolized.
+         *
+         * <p>The raw tombstones of all the processes are rendered by the first process which claims them,
+         * so the callback may be executed in a different process from the crashed one.
+         *
+         * @param flag True or false.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeDeferSymbolization(boolean flag) {
+            this.nativeDeferSymbols = flag;
+            return this;
+        }
+
         /**
          * Set a callback to be executed when a native crash occurred. (If not set, nothing will be happened.)
          *
@@ -903,4 +964,20 @@ public final class XCrash {
     public static void testNativeCrash(boolean runInNewThread) {
         NativeHandler.getInstance().testNativeCrash(runInNewThread);
     }
+
+    /**
+     * Dump the registers and native backtraces of the threads in the current process, without crashing.
+     *
+     * <p>All threads are suspended only while their registers, stacks and memory maps are captured,
+     * they are resumed before the backtraces are unwound and symbolized.
+     * The threads to be dumped are controlled by the native crash "dump all threads" allowlist and count limit.
+     *
+     * <p>Note: This method blocks until the dump finished, do NOT call it in the UI thread.
+     *
+     * @return The path of the native snapshot log file, or null if failed (or native crash capture is not enabled).
+     */
+    @SuppressWarnings("unused")
+    public static String dumpNativeSnapshot() {
+        return NativeHandler.getInstance().dumpNativeSnapshot();
+    }
 }